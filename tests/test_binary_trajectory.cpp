@@ -0,0 +1,200 @@
+// test_binary_trajectory.cpp - 二进制轨迹（.xyzb）：写入/读取往返（float32与float64）、元素ID重映射、
+// 截断与损坏文件的拒绝，以及从.xyzb转换与从文本转换得到逐字节相同的Gaussian log
+#include "test_common.h"
+
+#include <random>
+
+namespace {
+
+// 三帧水分子，第三帧原子顺序不同（新拓扑）；坐标包含float32无法精确表示的值
+const char* const WATER_TRAJECTORY =
+    "3\nframe 0\nO 0.000000 0.000000 0.117300\nH 0.000000 0.757200 -0.469200\nH 0.000000 -0.757200 -0.469200\n"
+    "3\nframe 1\nO 0.100000 0.000000 0.117300\nH 0.000000 0.757200 -0.469200\nH 1.234567 -0.757200 -0.469200\n"
+    "3\n\"quoted\" comment\nH 0.333333 0.757200 -0.469200\nO 0.000000 0.000000 0.117300\nH -9.876543 -0.757200 1e-7\n";
+
+std::string writeBinary(const Trajectory& trajectory, bool useDouble) {
+    BinaryTrajectoryWriter writer(useDouble);
+    if (!writer.create() || !writer.append(trajectory) || !writer.finish()) {
+        return "";
+    }
+    return writer.filePath();
+}
+
+Trajectory readBinary(const BinaryTrajectoryReader& reader) {
+    std::vector<size_t> frames(reader.frameCount());
+    for (size_t i = 0; i < frames.size(); ++i) frames[i] = i;
+    Trajectory trajectory;
+    reader.readFrames(frames.data(), frames.size(), trajectory);
+    return trajectory;
+}
+
+// 逐原子比较符号、坐标（float32时与单精度舍入后的值比较）及各帧注释
+bool sameTrajectory(const Trajectory& expected, const Trajectory& actual, bool useDouble) {
+    if (expected.frameCount() != actual.frameCount() || expected.totalAtoms() != actual.totalAtoms()) return false;
+    auto round = [&](double value) { return useDouble ? value : static_cast<double>(static_cast<float>(value)); };
+    for (size_t frame = 0; frame < expected.frameCount(); ++frame) {
+        if (expected.frameAtomCount(frame) != actual.frameAtomCount(frame) ||
+            expected.comments[frame] != actual.comments[frame]) {
+            return false;
+        }
+        const std::vector<uint32_t>& expectedIds = expected.frameElements(frame);
+        const std::vector<uint32_t>& actualIds = actual.frameElements(frame);
+        for (size_t i = 0; i < expectedIds.size(); ++i) {
+            size_t atom = expected.frameOffsets[frame] + i;
+            if (expected.elements[expectedIds[i]] != actual.elements[actualIds[i]] ||
+                round(expected.x[atom]) != actual.x[atom] || round(expected.y[atom]) != actual.y[atom] ||
+                round(expected.z[atom]) != actual.z[atom]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 把轨迹文本经完整转换写成Gaussian log，capture非空时同时写出二进制轨迹
+std::string convertTextToLog(std::string_view content, BinaryTrajectoryWriter* capture) {
+    OutputFileWriter writer(writeBufferBytes());
+    std::string path = createUniqueTempFile(writer);
+    StreamStats stats;
+    if (path.empty() || !convertXYZToGaussianLog(content, writer, FrameSelection(), stats, nullptr, capture)) {
+        return "";
+    }
+    return readTestFile(path);
+}
+
+std::string convertBinaryToLog(const std::string& binaryPath) {
+    BinaryTrajectoryReader reader;
+    OutputFileWriter writer(writeBufferBytes());
+    std::string path = createUniqueTempFile(writer);
+    StreamStats stats;
+    if (!reader.open(binaryPath) || path.empty() ||
+        !convertBinaryTrajectoryToGaussianLog(reader, writer, FrameSelection(), stats)) {
+        return "";
+    }
+    return readTestFile(path);
+}
+
+} // namespace
+
+TEST(roundTripFloat64) {
+    Trajectory original = readMultiXYZ(WATER_TRAJECTORY);
+    CHECK(original.frameCount() == 3);
+    
+    std::string path = writeBinary(original, true);
+    CHECK(!path.empty());
+    BinaryTrajectoryReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.doublePrecision());
+    CHECK(reader.frameCount() == 3 && reader.totalAtoms() == 9);
+    CHECK(sameTrajectory(original, readBinary(reader), true));
+}
+
+TEST(roundTripFloat32) {
+    Trajectory original = readMultiXYZ(WATER_TRAJECTORY);
+    std::string path = writeBinary(original, false);
+    BinaryTrajectoryReader reader;
+    CHECK(reader.open(path));
+    CHECK(!reader.doublePrecision());
+    CHECK(sameTrajectory(original, readBinary(reader), false));
+}
+
+// 分批追加时各批的元素表顺序不同，读入时目标轨迹已有其他元素：符号必须按原子保持不变
+TEST(remappedElementIds) {
+    Trajectory first = readMultiXYZ("2\na\nC 0 0 0\nN 1 0 0\n");
+    Trajectory second = readMultiXYZ("3\nb\nN 0 1 0\nO 0 0 1\nC 1 1 1\n");
+    BinaryTrajectoryWriter writer(true);
+    CHECK(writer.create() && writer.append(first) && writer.append(second) && writer.finish());
+    
+    BinaryTrajectoryReader reader;
+    CHECK(reader.open(writer.filePath()));
+    Trajectory loaded;
+    loaded.addElement("Fe");
+    loaded.addElement("O");
+    std::vector<size_t> frames = {1, 0};
+    reader.readFrames(frames.data(), frames.size(), loaded);
+    
+    CHECK(loaded.frameCount() == 2);
+    const char* expected[] = {"N", "O", "C", "C", "N"};
+    for (size_t atom = 0, frame = 0; frame < loaded.frameCount(); ++frame) {
+        for (uint32_t id : loaded.frameElements(frame)) {
+            CHECK(loaded.elements[id] == expected[atom++]);
+        }
+    }
+    CHECK(loaded.comments[0] == "b" && loaded.comments[1] == "a");
+    CHECK(loaded.x[0] == 0 && loaded.y[0] == 1 && loaded.x[4] == 1);
+}
+
+TEST(rejectsTruncatedFiles) {
+    std::string path = writeBinary(readMultiXYZ(WATER_TRAJECTORY), true);
+    std::string bytes = readTestFile(path);
+    CHECK(bytes.size() > sizeof(BinaryTrajectoryTrailer));
+    
+    const size_t lengths[] = {0, 4, sizeof(BinaryTrajectoryHeader), sizeof(BinaryTrajectoryHeader) + 40,
+                              bytes.size() / 2, bytes.size() - sizeof(BinaryTrajectoryTrailer), bytes.size() - 1};
+    for (size_t length : lengths) {
+        std::string truncated = writeTestFile("truncated.xyzb", std::string_view(bytes).substr(0, length));
+        BinaryTrajectoryReader reader;
+        CHECK(!reader.open(truncated));
+    }
+}
+
+TEST(rejectsCorruptedTables) {
+    std::string path = writeBinary(readMultiXYZ(WATER_TRAJECTORY), false);
+    const std::string bytes = readTestFile(path);
+    const size_t trailerAt = bytes.size() - sizeof(BinaryTrajectoryTrailer);
+    
+    auto corrupt = [&](size_t offset, uint64_t value) {
+        std::string copy = bytes;
+        std::memcpy(&copy[offset], &value, sizeof(value));
+        BinaryTrajectoryReader reader;
+        return reader.open(writeTestFile("corrupt.xyzb", copy));
+    };
+    CHECK(!corrupt(0, 0));                                                                        // 魔数
+    CHECK(!corrupt(trailerAt + offsetof(BinaryTrajectoryTrailer, magic), 0));
+    CHECK(!corrupt(trailerAt + offsetof(BinaryTrajectoryTrailer, frameCount), 1ull << 40));
+    CHECK(!corrupt(trailerAt + offsetof(BinaryTrajectoryTrailer, totalAtoms), 10));
+    CHECK(!corrupt(trailerAt + offsetof(BinaryTrajectoryTrailer, elementsOffset), bytes.size() * 2));
+    CHECK(!corrupt(trailerAt + offsetof(BinaryTrajectoryTrailer, topologyCount), 0));
+    CHECK(!corrupt(trailerAt + offsetof(BinaryTrajectoryTrailer, commentsOffset), 0));
+    
+    // 随机改写字节：要么拒绝，要么通过校验后能完整读取而不越界
+    std::mt19937 random(17);
+    for (int round = 0; round < 2000; ++round) {
+        std::string copy = bytes;
+        for (int k = 0; k < 4; ++k) {
+            copy[random() % copy.size()] = static_cast<char>(random());
+        }
+        BinaryTrajectoryReader reader;
+        if (reader.open(writeTestFile("fuzz.xyzb", copy))) {
+            CHECK(readBinary(reader).totalAtoms() == reader.totalAtoms());
+        }
+    }
+}
+
+// 文本转换时顺带写出的float64轨迹，再转换得到的log与文本转换的结果逐字节相同（整体与流式两种路径）
+TEST(binaryLogMatchesTextLog) {
+    std::string content;
+    for (int frame = 0; frame < 40; ++frame) {
+        content += "4\nstep " + std::to_string(frame) + "\n";
+        content += "C " + std::to_string(frame * 0.013) + " -1.250000 3.5\n";
+        content += "Cl 0.1 " + std::to_string(-frame * 1.7) + " 2.25\n";
+        content += "H 1e-3 12345.678901 -0.000001\n";
+        content += "Xx 0 0 " + std::to_string(frame) + "\n";
+    }
+    
+    const bool streamConversion = g_config.streamConversion;
+    for (bool stream : {false, true}) {
+        g_config.streamConversion = stream;
+        BinaryTrajectoryWriter capture(true);
+        CHECK(capture.create());
+        std::string textLog = convertTextToLog(content, &capture);
+        CHECK(!textLog.empty());
+        CHECK(capture.frameCount() == 40 && capture.finish());
+        CHECK(convertBinaryToLog(capture.filePath()) == textLog);
+    }
+    g_config.streamConversion = streamConversion;
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,173 @@
+// test_clipboard.cpp - ClipboardText：借用与复制两种模式下剪贴板的占用时间、release()后视图与缓冲区的状态、
+// 超过64MB的复制缓冲区释放、流式转换前detach()归还剪贴板，整体转换在解析完成后调用inputParsed归还剪贴板，
+// 以及按分配大小确定剪贴板文本长度
+#include "test_common.h"
+
+namespace {
+
+// 内存剪贴板是否仍被打开（借用中）
+bool isOpen(const MemoryClipboardSource& source) {
+    return !source.text().empty();
+}
+
+std::string waterFrames(size_t frames) {
+    std::string content;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        content += "3\nframe " + std::to_string(frame) + "\nO 0.000000 0.000000 0.117300\n"
+                   "H 0.000000 0.757200 -0.469200\nH 0.000000 -0.757200 -0.469200\n";
+    }
+    return content;
+}
+
+} // namespace
+
+// 借用：视图直接指向剪贴板中的文本，release()前剪贴板一直打开
+TEST(borrowHoldsClipboardUntilRelease) {
+    MemoryClipboardSource source("3\nwater\nO 0 0 0\nH 0 1 0\nH 1 0 0\n");
+    std::string buffer;
+    ClipboardText text(source, buffer);
+    CHECK(text.acquire(true));
+    CHECK(isOpen(source));
+    CHECK(text.view().data() == source.text().data());
+    CHECK(buffer.empty());
+    
+    text.release();
+    CHECK(!isOpen(source));
+    CHECK(text.view().empty());
+}
+
+// 复制：文本复制到调用方的缓冲区后立即归还剪贴板
+TEST(copyReleasesClipboardImmediately) {
+    const std::string contents = "2\ncopy\nC 0 0 0\nO 0 0 1.2\n";
+    MemoryClipboardSource source(contents);
+    std::string buffer;
+    ClipboardText text(source, buffer);
+    CHECK(text.acquire(false));
+    CHECK(!isOpen(source));
+    CHECK(text.view() == contents);
+    CHECK(text.view().data() == buffer.data());
+    
+    text.release();
+    CHECK(text.view().empty());
+    CHECK(buffer.empty());
+}
+
+TEST(emptyClipboardIsNotAcquired) {
+    MemoryClipboardSource source;
+    std::string buffer;
+    ClipboardText text(source, buffer);
+    CHECK(!text.acquire(true));
+    CHECK(!text.acquire(false));
+    CHECK(text.view().empty());
+}
+
+// 析构时归还借用的剪贴板；再次acquire先归还上一次的
+TEST(destructorAndReacquireRelease) {
+    MemoryClipboardSource source("1\na\nH 0 0 0\n");
+    std::string buffer;
+    {
+        ClipboardText text(source, buffer);
+        CHECK(text.acquire(true));
+        CHECK(isOpen(source));
+        CHECK(text.acquire(false));
+        CHECK(!isOpen(source));
+        CHECK(text.acquire(true));
+    }
+    CHECK(!isOpen(source));
+}
+
+// detach()把借用的文本复制到缓冲区并归还剪贴板；复制模式下不做任何事
+TEST(detachCopiesBorrowedText) {
+    const std::string contents = "2\ndetach\nC 0 0 0\nO 0 0 1.2\n";
+    MemoryClipboardSource source(contents);
+    std::string buffer;
+    ClipboardText text(source, buffer);
+    CHECK(text.acquire(true));
+    std::string_view detached = text.detach();
+    CHECK(!isOpen(source));
+    CHECK(detached == contents);
+    CHECK(detached.data() == buffer.data());
+    CHECK(text.view().data() == buffer.data());
+    
+    CHECK(text.acquire(false));
+    CHECK(text.detach().data() == buffer.data());
+    text.release();
+    CHECK(text.detach().empty());
+}
+
+// 结束符在分配末尾、分配远大于文本（其后全为NUL）以及没有结束符的情况
+TEST(clipboardTextLengthFindsTerminator) {
+    std::string small = "abc";
+    small.append(13, '\0');
+    CHECK(clipboardTextLength(small.data(), small.size()) == 3);
+    
+    std::string large(100000, 'x');
+    large.append(1, '\0');
+    large.append(7, '\x7f');
+    CHECK(clipboardTextLength(large.data(), large.size()) == 100000);
+    
+    std::string padded(100000, 'x');
+    padded.append(50000, '\0');
+    CHECK(clipboardTextLength(padded.data(), padded.size()) == 100000);
+    
+    std::string exact(5000, 'x');
+    exact.append(4096, '\0');
+    CHECK(clipboardTextLength(exact.data(), exact.size()) == 5000);
+    
+    std::string unterminated(10000, 'x');
+    CHECK(clipboardTextLength(unterminated.data(), unterminated.size()) == 10000);
+    CHECK(clipboardTextLength(unterminated.data(), 0) == 0);
+}
+
+// 不超过64MB的复制缓冲区在转换之间保留容量，更大的在release()时释放
+TEST(largeCopyBufferIsFreed) {
+    std::string buffer;
+    MemoryClipboardSource small(std::string(1 << 20, 'x'));
+    {
+        ClipboardText text(small, buffer);
+        CHECK(text.acquire(false));
+        text.release();
+        CHECK(buffer.empty() && buffer.capacity() >= (1 << 20));
+    }
+    
+    MemoryClipboardSource large(std::string(65 * 1024 * 1024, 'x'));
+    ClipboardText text(large, buffer);
+    CHECK(text.acquire(false));
+    CHECK(text.view().size() == 65u * 1024 * 1024);
+    text.release();
+    CHECK(buffer.capacity() < 1024);
+}
+
+// 整体转换在解析完成后、写出之前调用inputParsed一次；流式转换直到写完都读取文本，不调用
+TEST(conversionReleasesInputAfterParsing) {
+    const std::string content = waterFrames(50);
+    const std::string expected = convertToGaussianLog(readMultiXYZ(content));
+    const bool streamConversion = g_config.streamConversion;
+    for (bool stream : {false, true}) {
+        g_config.streamConversion = stream;
+        MemoryClipboardSource source(content);
+        std::string buffer;
+        ClipboardText text(source, buffer);
+        CHECK(text.acquire(true));
+        
+        OutputFileWriter writer(writeBufferBytes());
+        std::string path = createUniqueTempFile(writer);
+        StreamStats stats;
+        int released = 0;
+        bool converted = convertContentToGaussianLog(text.view(), sniffFormat(text.view()).format, writer, FrameSelection(),
+                                                     stats, nullptr, nullptr, [&]() {
+                                                         ++released;
+                                                         text.release();
+                                                     });
+        CHECK(converted);
+        CHECK(conversionReadsUntilWritten(content, sniffFormat(content).format) == stream);
+        CHECK(released == (stream ? 0 : 1));
+        CHECK(stats.frames == 50);
+        CHECK(readTestFile(path) == expected);
+    }
+    g_config.streamConversion = streamConversion;
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
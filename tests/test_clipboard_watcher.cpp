@@ -0,0 +1,78 @@
+// test_clipboard_watcher.cpp - Gaussian clipboard文件监视：文件写入（含分多次写入、替换）经去抖后只重新解析一次，
+// 缓存结果与文件当前版本一致，文件内容未变时不重新解析
+#include "test_common.h"
+
+namespace {
+
+std::string clipboardFile(int atoms, double shift) {
+    std::string content = "Gaussian clipboard\n" + std::to_string(atoms) + "\n";
+    for (int atom = 0; atom < atoms; ++atom) {
+        content += (atom % 2 ? "1 " : "8 ") + std::to_string(atom + shift) + " 0.000000 0.000000\n";
+    }
+    return content;
+}
+
+// 等待后台解析次数达到count，再等待一段时间确认不会多出来
+bool waitForParses(const ClipboardFileWatcher& watcher, size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (watcher.parseCount() < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    return watcher.parseCount() == count;
+}
+
+} // namespace
+
+// 分几次写入的新文件只触发一次解析，解析结果可直接取用
+TEST(droppedFileParsesOnce) {
+    const std::string path = testDir() + "/watched/clipboard.frg";
+    std::filesystem::create_directories(testDir() + "/watched");
+    ClipboardFileWatcher watcher;
+    watcher.start(path);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(watcher.parseCount() == 0);
+    
+    const std::string content = clipboardFile(3, 0.0);
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (size_t pos = 0; pos < content.size(); pos += 16) {
+            file << content.substr(pos, 16);
+            file.flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    CHECK(waitForParses(watcher, 1));
+    
+    std::shared_ptr<const ParsedClipboardFile> parsed = watcher.current(path);
+    CHECK(parsed != nullptr);
+    CHECK(parsed && parsed->atoms.totalAtoms() == 3);
+    CHECK(parsed && parsed->xyz == createXYZString(parsed->atoms));
+    watcher.stop();
+}
+
+// 替换文件（写入临时文件后改名）触发一次解析，之后目录中其他文件的变化不会再解析
+TEST(replacedFileParsesOnce) {
+    const std::string directory = testDir() + "/replaced";
+    const std::string path = directory + "/clipboard.frg";
+    std::filesystem::create_directories(directory);
+    writeTestFile("replaced/clipboard.frg", clipboardFile(2, 0.0));
+    
+    ClipboardFileWatcher watcher;
+    watcher.start(path);
+    CHECK(waitForParses(watcher, 1));
+    
+    writeTestFile("replaced/clipboard.tmp", clipboardFile(5, 1.0));
+    std::filesystem::rename(directory + "/clipboard.tmp", path);
+    CHECK(waitForParses(watcher, 2));
+    std::shared_ptr<const ParsedClipboardFile> parsed = watcher.current(path);
+    CHECK(parsed && parsed->atoms.totalAtoms() == 5);
+    
+    writeTestFile("replaced/other.txt", "other");
+    CHECK(waitForParses(watcher, 2));
+    watcher.stop();
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,84 @@
+// test_common.h - 单元测试公用工具：TEST登记测试函数，CHECK记录失败后继续执行。
+// 每个tests/test_*.cpp是链接libxyzcore.a的独立程序，由make test依次运行（Linux）
+#pragma once
+
+#include "xyz_core.h"
+
+struct TestCase {
+    const char* name;
+    void (*func)();
+};
+
+inline std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*func)()) {
+        testCases().push_back({name, func});
+    }
+};
+
+#define TEST(name)                                         \
+    static void name();                                    \
+    static TestRegistrar name##Registrar(#name, name);     \
+    static void name()
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            ++testFailures();                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+        }                                                                                  \
+    } while (0)
+
+// 测试程序的临时目录（g_config.tempDir也指向其下），运行结束时删除
+inline const std::string& testDir() {
+    static const std::string dir = (std::filesystem::temp_directory_path() /
+                                    ("xyz_test_" + std::to_string(::getpid()))).string();
+    return dir;
+}
+
+inline std::string writeTestFile(const std::string& name, std::string_view content) {
+    std::string path = testDir() + "/" + name;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return path;
+}
+
+inline std::string readTestFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// 运行已登记的测试（可用参数按名称子串过滤），有失败时返回1
+inline int runTests(int argc, char** argv) {
+    // 预期中的失败（损坏的文件等）会记录错误日志，测试输出只保留CHECK的结果
+    g_logger.setLogToFile(false);
+    g_logger.setLogToConsole(false);
+    std::filesystem::create_directories(testDir());
+    g_config.tempDir = testDir() + "/temp";
+    
+    int run = 0;
+    for (const TestCase& test : testCases()) {
+        if (argc > 1 && std::strstr(test.name, argv[1]) == nullptr) continue;
+        int before = testFailures();
+        test.func();
+        ++run;
+        std::printf("[%s] %s\n", testFailures() == before ? " OK " : "FAIL", test.name);
+    }
+    
+    g_logger.shutdown();
+    std::error_code ec;
+    std::filesystem::remove_all(testDir(), ec);
+    std::printf("%d test(s), %d failed check(s)\n", run, testFailures());
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// test_elements.cpp - getAtomicNumber：元素符号（不区分大小写）、带编号或后缀的标签、PDB式氢原子名、
+// 数字形式的原子序数，以及虚原子和无法识别的标签返回0
+#include "test_common.h"
+
+TEST(resolvesEverySymbol) {
+    bool all = true;
+    for (int number = 1; number <= MAX_ATOMIC_NUMBER; ++number) {
+        std::string symbol = elementSymbol(number);
+        std::string upper = symbol;
+        std::string lower = symbol;
+        std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        all = all && getAtomicNumber(symbol) == number && getAtomicNumber(upper) == number &&
+              getAtomicNumber(lower) == number && getAtomicNumber(" " + symbol + " ") == number;
+    }
+    CHECK(all);
+}
+
+// 第二个字符不是字母时才按第一个字母取元素
+TEST(resolvesNumberedLabels) {
+    CHECK(getAtomicNumber("C12") == 6);
+    CHECK(getAtomicNumber("C_a") == 6);
+    CHECK(getAtomicNumber("N-1") == 7);
+    CHECK(getAtomicNumber("Fe_a") == 26);
+    CHECK(getAtomicNumber("Cl2") == 17);
+    CHECK(getAtomicNumber("Cu1") == 29);
+    CHECK(getAtomicNumber("Ca") == 20);
+}
+
+TEST(resolvesHydrogenNames) {
+    CHECK(getAtomicNumber("HA") == 1);
+    CHECK(getAtomicNumber("HB2") == 1);
+    CHECK(getAtomicNumber("HN") == 1);
+    CHECK(getAtomicNumber("HE") == 2);
+    CHECK(getAtomicNumber("HG") == 80);
+    CHECK(getAtomicNumber("Ha") == 0);
+    CHECK(getAtomicNumber("hA") == 0);
+}
+
+// 虚原子与无法识别的标签不会被当成以同一字母开头的元素（Bq不是硼）
+TEST(rejectsDummyAndUnknownLabels) {
+    for (const char* label : {"Bq", "BQ", "bq", "X", "x", "Gh", "GH", "Xx", "Xyz", "Bq1", "Ow", "", "  ", "-C", "_"}) {
+        if (getAtomicNumber(label) != 0) {
+            std::fprintf(stderr, "  %s resolved to %d\n", label, getAtomicNumber(label));
+            CHECK(false);
+        }
+    }
+}
+
+TEST(resolvesAtomicNumbers) {
+    CHECK(getAtomicNumber("1") == 1);
+    CHECK(getAtomicNumber("+8") == 8);
+    CHECK(getAtomicNumber("118") == 118);
+    CHECK(getAtomicNumber("0") == 0);
+    CHECK(getAtomicNumber("119") == 0);
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
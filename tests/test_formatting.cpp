@@ -0,0 +1,188 @@
+// test_formatting.cpp - 坐标格式化：formatFixed6与iostream（std::fixed、精度6、setw）在整个double范围内逐字节一致，
+// fixed6Length与实际输出长度一致（两遍写出依赖于此），以及Gaussian log几何结构与XYZ文本的金标准输出
+#include "test_common.h"
+
+#include <cfloat>
+#include <random>
+
+namespace {
+
+// 参照实现：原先基于ostringstream的格式化
+std::string streamFixed6(double value, int width) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(6) << std::setw(width) << value;
+    return oss.str();
+}
+
+std::string referenceGeometry(const Trajectory& trajectory, size_t frame, int frameNumber) {
+    const std::vector<uint32_t>& ids = trajectory.frameElements(frame);
+    size_t begin = trajectory.frameOffsets[frame];
+    std::ostringstream oss;
+    oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
+    oss << " \n";
+    oss << "                         Standard orientation:\n";
+    oss << " ---------------------------------------------------------------------\n";
+    oss << " Center     Atomic      Atomic             Coordinates (Angstroms)\n";
+    oss << " Number     Number       Type             X           Y           Z\n";
+    oss << " ---------------------------------------------------------------------\n";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        oss << "      " << (i + 1) << "          " << getAtomicNumber(trajectory.elements[ids[i]])
+            << "           0        " << std::fixed << std::setprecision(6)
+            << std::setw(10) << trajectory.x[begin + i] << "    "
+            << std::setw(10) << trajectory.y[begin + i] << "    "
+            << std::setw(10) << trajectory.z[begin + i] << "\n";
+    }
+    oss << " ---------------------------------------------------------------------\n";
+    oss << " \n";
+    oss << " SCF Done:      -100.000000000\n";
+    oss << " \n";
+    oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
+    oss << " Step number   " << frameNumber << "\n";
+    oss << "         Item               Value     Threshold  Converged?\n";
+    oss << " Maximum Force            1.000000     1.000000     NO\n";
+    oss << " RMS     Force            1.000000     1.000000     NO\n";
+    oss << " Maximum Displacement     1.000000     1.000000     NO\n";
+    oss << " RMS     Displacement     1.000000     1.000000     NO\n";
+    return oss.str();
+}
+
+std::string referenceXYZ(const Trajectory& trajectory, size_t frame) {
+    const std::vector<uint32_t>& ids = trajectory.frameElements(frame);
+    size_t begin = trajectory.frameOffsets[frame];
+    std::ostringstream oss;
+    oss << ids.size() << std::endl;
+    oss << "Converted from Gaussian clipboard" << std::endl;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        oss << std::left << std::setw(2) << trajectory.elements[ids[i]]
+            << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << trajectory.x[begin + i]
+            << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << trajectory.y[begin + i]
+            << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << trajectory.z[begin + i]
+            << std::endl;
+    }
+    return oss.str();
+}
+
+// 边界值：零与符号、非规格化数、10的各次幂及其相邻值、第6位小数的舍入与进位、极值与非有限值
+std::vector<double> edgeValues() {
+    std::vector<double> values = {0.0, -0.0, DBL_MIN, -DBL_MIN, DBL_MAX, -DBL_MAX, DBL_EPSILON,
+                                  std::numeric_limits<double>::denorm_min(), 4.9406564584124654e-324 * 7,
+                                  std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                                  std::numeric_limits<double>::quiet_NaN(),
+                                  0.0000005, 0.0000015, 0.0000025, -0.0000004, -0.0000005, -0.0000006,
+                                  9.9999995, 9.9999994999, 99999.9999995, 999999999999999.9, 1e15, 1e15 - 0.5,
+                                  123456789012345678.0, 0.1173, -0.4692, 0.7572, 1.2345675, 2.5e-7};
+    for (int exponent = -320; exponent <= 308; ++exponent) {
+        double power = std::pow(10.0, exponent);
+        for (double value : {power, std::nextafter(power, 0.0), std::nextafter(power, DBL_MAX),
+                             power * 0.9999995, power - 5e-7}) {
+            values.push_back(value);
+            values.push_back(-value);
+        }
+    }
+    return values;
+}
+
+bool fixed6Matches(double value, int width) {
+    char buffer[FIXED6_MAX_CHARS + 16];
+    char* end = formatFixed6(buffer, value, width);
+    std::string actual(buffer, end);
+    return actual == streamFixed6(value, width) && fixed6Length(value, width) == actual.size();
+}
+
+} // namespace
+
+TEST(fixed6MatchesIostreamOnEdgeValues) {
+    for (double value : edgeValues()) {
+        for (int width : {0, 10, 12}) {
+            if (!fixed6Matches(value, width)) {
+                std::fprintf(stderr, "  mismatch for %.17g (width %d)\n", value, width);
+                CHECK(false);
+            }
+        }
+    }
+}
+
+// 随机位模式覆盖整个double范围（含非规格化数与NaN），另有坐标范围内的随机值
+TEST(fixed6MatchesIostreamOnRandomValues) {
+    std::mt19937_64 random(6);
+    std::uniform_real_distribution<double> coordinate(-1000.0, 1000.0);
+    size_t mismatches = 0;
+    for (int i = 0; i < 300000; ++i) {
+        uint64_t bits = random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (!fixed6Matches(value, 10)) ++mismatches;
+        if (!fixed6Matches(coordinate(random), 12)) ++mismatches;
+        if (!fixed6Matches(std::round(coordinate(random) * 1e6) / 1e6 + 5e-7, 10)) ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+// 金标准：小分子的Gaussian log几何结构与XYZ文本
+TEST(goldenGeometryAndXYZ) {
+    Trajectory trajectory = readMultiXYZ("3\ngolden\nO 0.000000 0.000000 0.117300\n"
+                                         "H 0.000000 0.757200 -0.469200\nCl -123.4567891 1e-7 -0.0000004\n");
+    CHECK(trajectory.frameCount() == 1);
+    
+    const std::string geometry =
+        "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n"
+        " \n"
+        "                         Standard orientation:\n"
+        " ---------------------------------------------------------------------\n"
+        " Center     Atomic      Atomic             Coordinates (Angstroms)\n"
+        " Number     Number       Type             X           Y           Z\n"
+        " ---------------------------------------------------------------------\n"
+        "      1          8           0          0.000000      0.000000      0.117300\n"
+        "      2          1           0          0.000000      0.757200     -0.469200\n"
+        "      3          17           0        -123.456789      0.000000     -0.000000\n"
+        " ---------------------------------------------------------------------\n"
+        " \n"
+        " SCF Done:      -100.000000000\n"
+        " \n"
+        "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n"
+        " Step number   7\n"
+        "         Item               Value     Threshold  Converged?\n"
+        " Maximum Force            1.000000     1.000000     NO\n"
+        " RMS     Force            1.000000     1.000000     NO\n"
+        " Maximum Displacement     1.000000     1.000000     NO\n"
+        " RMS     Displacement     1.000000     1.000000     NO\n";
+    CHECK(writeGaussianLogGeometry(trajectory, 0, buildAtomicNumberTable(trajectory), 7) == geometry);
+    
+    const std::string xyz =
+        "3\n"
+        "Converted from Gaussian clipboard\n"
+        "O      0.000000     0.000000     0.117300\n"
+        "H      0.000000     0.757200    -0.469200\n"
+        "Cl  -123.456789     0.000000    -0.000000\n";
+    CHECK(createXYZString(trajectory, 0) == xyz);
+}
+
+// 极端坐标（宽度溢出、非有限值、长元素符号）下与参照实现逐字节一致，两遍写出的长度也一致
+TEST(geometryAndXYZMatchReferenceOnEdgeValues) {
+    std::vector<double> values = edgeValues();
+    static const char* const symbols[] = {"C", "Fe", "Xyz", "H"};
+    Trajectory trajectory;
+    const size_t atomsPerFrame = 30;
+    for (size_t begin = 0; begin < values.size(); begin += atomsPerFrame) {
+        trajectory.beginFrame("edge");
+        for (size_t i = begin; i < std::min(values.size(), begin + atomsPerFrame); ++i) {
+            trajectory.addAtom(symbols[i % 4], values[i], values[values.size() - 1 - i], values[(i * 7) % values.size()]);
+        }
+        trajectory.endFrame();
+    }
+    
+    std::vector<int> atomicNumbers = buildAtomicNumberTable(trajectory);
+    for (size_t frame = 0; frame < trajectory.frameCount(); ++frame) {
+        std::string geometry = writeGaussianLogGeometry(trajectory, frame, atomicNumbers, static_cast<int>(frame + 1));
+        CHECK(geometry == referenceGeometry(trajectory, frame, static_cast<int>(frame + 1)));
+        CHECK(gaussianLogGeometrySize(trajectory, frame, atomicNumbers, static_cast<int>(frame + 1)) == geometry.size());
+        
+        std::string xyz = createXYZString(trajectory, frame);
+        CHECK(xyz == referenceXYZ(trajectory, frame));
+        CHECK(xyzFrameSize(trajectory, frame) == xyz.size());
+    }
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,110 @@
+// test_gaussian_log.cpp - 并行格式化的Gaussian log与逐帧串行写出的结果逐字节相同（整体转换与流式转换）
+#include "test_common.h"
+
+#include <random>
+
+namespace {
+
+// 帧的原子数与元素顺序各不相同（多个拓扑），坐标覆盖不同的数量级与符号
+std::string generateTrajectory(size_t frames) {
+    static const char* const symbols[] = {"C", "H", "O", "N", "Cl", "Fe", "Xx"};
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> coordinate(-150.0, 150.0);
+    std::string content;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        size_t atoms = 1 + frame % 37;
+        content += std::to_string(atoms) + "\nframe " + std::to_string(frame) + "\n";
+        for (size_t i = 0; i < atoms; ++i) {
+            char line[128];
+            std::snprintf(line, sizeof(line), "%s %.9f %.3f %.12g\n", symbols[(frame + i) % 7],
+                          coordinate(random), coordinate(random) * 1e-3, coordinate(random) * 1e4);
+            content += line;
+        }
+    }
+    return content;
+}
+
+// 串行参照：头部、逐帧writeGaussianLogGeometry、尾部依次拼接
+std::string serialGaussianLog(const Trajectory& trajectory) {
+    std::vector<int> atomicNumbers = buildAtomicNumberTable(trajectory);
+    std::string output = writeGaussianLogHeader();
+    for (size_t frame = 0; frame < trajectory.frameCount(); ++frame) {
+        output += writeGaussianLogGeometry(trajectory, frame, atomicNumbers, static_cast<int>(frame + 1));
+    }
+    return output + writeGaussianLogFooter();
+}
+
+std::string convertFile(std::string_view content) {
+    OutputFileWriter writer(writeBufferBytes());
+    std::string path = createUniqueTempFile(writer);
+    StreamStats stats;
+    if (path.empty() || !convertXYZToGaussianLog(content, writer, FrameSelection(), stats)) {
+        return "";
+    }
+    return readTestFile(path);
+}
+
+} // namespace
+
+TEST(parallelFramesMatchSerialWriter) {
+    Trajectory trajectory = readMultiXYZ(generateTrajectory(700));
+    CHECK(trajectory.frameCount() == 700);
+    const std::string expected = serialGaussianLog(trajectory);
+    
+    const int workerThreads = g_config.workerThreads;
+    for (int threads : {1, 2, 3, 8, 16}) {
+        g_config.workerThreads = threads;
+        CHECK(convertToGaussianLog(trajectory) == expected);
+    }
+    g_config.workerThreads = workerThreads;
+}
+
+// 编号从firstFrameNumber开始，缓冲区按返回的总字节数恰好用满
+TEST(formatFramesFillsExactBuffer) {
+    Trajectory trajectory = readMultiXYZ(generateTrajectory(200));
+    std::vector<int> atomicNumbers = buildAtomicNumberTable(trajectory);
+    std::string expected;
+    for (size_t frame = 0; frame < trajectory.frameCount(); ++frame) {
+        expected += writeGaussianLogGeometry(trajectory, frame, atomicNumbers, static_cast<int>(frame + 41));
+    }
+    
+    std::string output;
+    size_t written = formatGaussianLogFrames(trajectory, 41, 8, [&](size_t bytes) {
+        output.assign(bytes + 16, '#');
+        return &output[0];
+    });
+    CHECK(written == expected.size());
+    CHECK(output.compare(0, written, expected) == 0);
+    CHECK(output.substr(written) == std::string(16, '#'));
+}
+
+// 流式转换（按批并行解析与格式化）与单线程整体转换写出的文件相同；1MB的上限与64KB的写缓冲区使转换分成多批
+TEST(streamingMatchesWholeConversion) {
+    const std::string content = generateTrajectory(3000);
+    const bool streamConversion = g_config.streamConversion;
+    const int workerThreads = g_config.workerThreads;
+    const int maxMemoryMB = g_config.maxMemoryMB;
+    const int writeBufferKB = g_config.writeBufferKB;
+    
+    g_config.streamConversion = false;
+    g_config.workerThreads = 1;
+    const std::string expected = convertFile(content);
+    CHECK(!expected.empty());
+    CHECK(expected == serialGaussianLog(readMultiXYZ(content)));
+    
+    g_config.streamConversion = true;
+    g_config.maxMemoryMB = 1;
+    g_config.writeBufferKB = 64;
+    for (int threads : {1, 8}) {
+        g_config.workerThreads = threads;
+        CHECK(convertFile(content) == expected);
+    }
+    g_config.streamConversion = streamConversion;
+    g_config.workerThreads = workerThreads;
+    g_config.maxMemoryMB = maxMemoryMB;
+    g_config.writeBufferKB = writeBufferKB;
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,171 @@
+// test_jobs.cpp - 转换任务队列：同一方向的排队任务合并、取消正在执行的任务、停止时丢弃排队任务，
+// 以及任务在开始时取得的配置快照不受之后重新加载配置的影响
+#include "test_common.h"
+
+namespace {
+
+// 任务在gate打开前一直阻塞（或被取消），记录执行顺序
+struct GatedRunner {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<ConversionDirection> started;
+    std::vector<bool> cancelled;
+    bool open = false;
+    
+    void run(ConversionDirection direction, ConversionProgress& progress) {
+        std::unique_lock<std::mutex> lock(mutex);
+        started.push_back(direction);
+        changed.notify_all();
+        while (!open && !progress.cancelled.load()) {
+            changed.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        cancelled.push_back(progress.cancelled.load());
+        changed.notify_all();
+    }
+    
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        changed.notify_all();
+    }
+    
+    // 等待第count个任务开始（或结束时finished为true）
+    bool waitFor(size_t count, bool finished) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(10), [&]() {
+            return (finished ? cancelled.size() : started.size()) >= count;
+        });
+    }
+};
+
+void startQueue(ConversionJobQueue& queue, GatedRunner& runner) {
+    queue.start([&runner](ConversionDirection direction, ConversionProgress& progress) { runner.run(direction, progress); },
+                []() {});
+}
+
+} // namespace
+
+// 执行中的任务不参与合并；排队中的同一方向再次提交时返回false
+TEST(coalescesQueuedSubmissions) {
+    GatedRunner runner;
+    ConversionJobQueue queue;
+    startQueue(queue, runner);
+    
+    CHECK(queue.submit(ConversionDirection::XYZToGView));
+    CHECK(runner.waitFor(1, false));
+    CHECK(queue.status().busy);
+    
+    CHECK(queue.submit(ConversionDirection::XYZToGView));
+    CHECK(queue.submit(ConversionDirection::GViewToXYZ));
+    CHECK(!queue.submit(ConversionDirection::XYZToGView));
+    CHECK(!queue.submit(ConversionDirection::GViewToXYZ));
+    CHECK(queue.submit(ConversionDirection::XYZToGViewOverride));
+    CHECK(queue.status().queued == 3);
+    
+    runner.release();
+    CHECK(runner.waitFor(4, true));
+    const std::vector<ConversionDirection> expected = {ConversionDirection::XYZToGView, ConversionDirection::XYZToGView,
+                                                       ConversionDirection::GViewToXYZ,
+                                                       ConversionDirection::XYZToGViewOverride};
+    std::lock_guard<std::mutex> lock(runner.mutex);
+    CHECK(runner.started == expected);
+}
+
+// 取消只作用于正在执行的任务，排队任务随后照常执行
+TEST(cancelsCurrentJob) {
+    GatedRunner runner;
+    ConversionJobQueue queue;
+    startQueue(queue, runner);
+    CHECK(!queue.cancelCurrent());
+    
+    CHECK(queue.submit(ConversionDirection::GViewToXYZ));
+    CHECK(runner.waitFor(1, false));
+    CHECK(queue.submit(ConversionDirection::XYZToGView));
+    CHECK(queue.cancelCurrent());
+    CHECK(runner.waitFor(2, false));
+    CHECK(queue.status().direction == ConversionDirection::XYZToGView);
+    
+    runner.release();
+    CHECK(runner.waitFor(2, true));
+    std::lock_guard<std::mutex> lock(runner.mutex);
+    CHECK(runner.cancelled.size() == 2 && runner.cancelled[0] && !runner.cancelled[1]);
+}
+
+// 停止时取消正在执行的任务，排队任务不再执行
+TEST(stopDiscardsQueuedJobs) {
+    GatedRunner runner;
+    ConversionJobQueue queue;
+    startQueue(queue, runner);
+    CHECK(queue.submit(ConversionDirection::XYZToGView));
+    CHECK(runner.waitFor(1, false));
+    CHECK(queue.submit(ConversionDirection::GViewToXYZ));
+    
+    queue.stop();
+    std::lock_guard<std::mutex> lock(runner.mutex);
+    CHECK(runner.started.size() == 1);
+    CHECK(runner.cancelled.size() == 1 && runner.cancelled[0]);
+    CHECK(!queue.status().busy);
+}
+
+// 任务执行期间重新加载配置：任务（及其parallelFor工作线程）读到的仍是开始时的快照
+TEST(jobsReadConfigSnapshot) {
+    const Config saved = g_config;
+    const std::string configFile = writeTestFile("jobs.ini", "gview_path=before.exe\nframe_last=5\nmax_memory_mb=300\n");
+    CHECK(loadConfig(configFile));
+    
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool started = false;
+    bool reloaded = false;
+    std::vector<std::string> seenPaths;
+    std::atomic<size_t> mismatches(0);
+    ConversionJobQueue queue;
+    queue.start(
+        [&](ConversionDirection, ConversionProgress&) {
+            std::unique_lock<std::mutex> lock(mutex);
+            started = true;
+            changed.notify_all();
+            changed.wait(lock, [&]() { return reloaded; });
+            lock.unlock();
+            
+            const Config& snapshot = activeConfig();
+            parallelFor(64, 4, 1, [&](size_t) {
+                if (&activeConfig() != &snapshot) mismatches.fetch_add(1);
+            });
+            lock.lock();
+            seenPaths.push_back(snapshot.gviewPath + " " + std::to_string(snapshot.frameSelection.lastN) + " " +
+                                std::to_string(snapshot.maxMemoryMB));
+            changed.notify_all();
+        },
+        []() {});
+    
+    CHECK(queue.submit(ConversionDirection::XYZToGView));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return started; });
+    }
+    writeTestFile("jobs.ini", "gview_path=after.exe\nframe_last=9\nmax_memory_mb=400\n");
+    CHECK(loadConfig(configFile));
+    CHECK(g_config.gviewPath == "after.exe" && g_config.frameSelection.lastN == 9);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reloaded = true;
+        changed.notify_all();
+    }
+    
+    // 下一个任务取得重新加载后的快照
+    CHECK(queue.submit(ConversionDirection::XYZToGView));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        CHECK(changed.wait_for(lock, std::chrono::seconds(10), [&]() { return seenPaths.size() == 2; }));
+    }
+    queue.stop();
+    CHECK(mismatches.load() == 0);
+    CHECK(seenPaths == std::vector<std::string>({"before.exe 5 300", "after.exe 9 400"}));
+    CHECK(t_activeConfig == nullptr);
+    g_config = saved;
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
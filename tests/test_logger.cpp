@@ -0,0 +1,71 @@
+// test_logger.cpp - 异步日志：其他线程仍在写日志时shutdown()不丢失消息（之后回到同步输出），
+// 以及缓冲区满时丢弃的消息数被如实报告
+#include "test_common.h"
+
+namespace {
+
+constexpr int THREADS = 4;
+constexpr int MESSAGES = 3000;
+
+// 各线程写MESSAGES条日志，主线程在写到一半时停止异步输出；返回日志文件内容
+std::string logDuringShutdown(const std::string& name, bool blockOnFull) {
+    const std::string path = testDir() + "/" + name;
+    {
+        Logger logger;
+        CHECK(logger.initialize(path, LogLevel::INFO));
+        logger.setLogToConsole(false);
+        logger.startAsync(blockOnFull);
+        
+        std::atomic<int> written(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&logger, &written, t]() {
+                for (int i = 0; i < MESSAGES; ++i) {
+                    logger.log(LogLevel::INFO, "message " + std::to_string(t) + "-" + std::to_string(i));
+                    written.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        while (written.load() < THREADS * MESSAGES / 2) {
+            std::this_thread::yield();
+        }
+        logger.shutdown();
+        for (auto& thread : threads) thread.join();
+    }
+    return readTestFile(path);
+}
+
+size_t countOccurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + needle.size())) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(shutdownKeepsConcurrentMessages) {
+    for (int round = 0; round < 5; ++round) {
+        std::string log = logDuringShutdown("shutdown_" + std::to_string(round) + ".log", true);
+        CHECK(countOccurrences(log, "[INFO]  message ") == static_cast<size_t>(THREADS * MESSAGES));
+        CHECK(log.find("message 0-" + std::to_string(MESSAGES - 1) + "\n") != std::string::npos);
+    }
+}
+
+// 不阻塞时写出的消息与报告的丢弃数之和等于写入的消息数
+TEST(droppedMessagesAreReported) {
+    std::string log = logDuringShutdown("dropping.log", false);
+    size_t kept = countOccurrences(log, "[INFO]  message ");
+    size_t dropped = 0;
+    const std::string suffix = " log message(s) dropped";
+    for (size_t pos = log.find(suffix); pos != std::string::npos; pos = log.find(suffix, pos + 1)) {
+        size_t start = log.rfind(' ', pos - 1) + 1;
+        dropped += std::stoul(log.substr(start, pos - start));
+    }
+    CHECK(kept + dropped == static_cast<size_t>(THREADS * MESSAGES));
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,105 @@
+// test_memory_budget.cpp - 转换内存预算：超出上限的分配抛出std::bad_alloc，槽用完时预算不统计，
+// 在预算内调用parallelFor时线程池在预算之外补充线程，以及解析时超出预算报告为预算超出而不是格式错误
+#include "test_common.h"
+
+TEST(exceedingLimitThrows) {
+    MemoryBudget budget(1 << 20);
+    CHECK(budget.tracking());
+    bool thrown = false;
+    {
+        MemoryBudgetScope scope(budget, nullptr);
+        std::vector<char> small(1 << 10);
+        try {
+            std::vector<char> large(2 << 20);
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        // 超出后不再限制，只继续统计
+        std::vector<char> after(2 << 20);
+        CHECK(!after.empty());
+    }
+    CHECK(thrown);
+    CHECK(budget.exceeded());
+    CHECK(budget.peak() >= (1 << 10));
+}
+
+// 槽用完时的预算不统计也不限制（并记录警告），释放后新的预算重新得到槽
+TEST(exhaustedSlotsRunUntracked) {
+    std::vector<std::unique_ptr<MemoryBudget>> budgets;
+    for (uint32_t i = 0; i < MEMORY_BUDGET_SLOTS + 4; ++i) {
+        budgets.push_back(std::make_unique<MemoryBudget>(1024));
+    }
+    size_t tracked = 0;
+    for (const auto& budget : budgets) tracked += budget->tracking() ? 1 : 0;
+    CHECK(tracked == MEMORY_BUDGET_SLOTS);
+    
+    MemoryBudget& untracked = *budgets.back();
+    CHECK(!untracked.tracking());
+    {
+        MemoryBudgetScope scope(untracked, nullptr);
+        std::vector<char> large(1 << 20);
+        CHECK(!untracked.exceeded());
+    }
+    
+    budgets.clear();
+    MemoryBudget budget(1024);
+    CHECK(budget.tracking());
+}
+
+// 预算很小时parallelFor仍需创建新线程：线程在预算之外创建，不会因bad_alloc终止或使预算超出
+TEST(parallelForSpawnsOutsideBudget) {
+    MemoryBudget budget(16 * 1024);
+    std::vector<std::atomic<int>> hits(4096);
+    {
+        MemoryBudgetScope scope(budget, nullptr);
+        parallelFor(hits.size(), 64, 1, [&](size_t i) { hits[i].fetch_add(1); });
+    }
+    bool once = true;
+    for (auto& hit : hits) once = once && hit.load() == 1;
+    CHECK(once);
+    CHECK(!budget.exceeded());
+    CHECK(workerPool().threadCount() > 1);
+}
+
+// 整体转换（含帧选择）在解析时超出预算（帧扫描在预算内）：转换失败并报告超出的预算，不记录"Invalid XYZ format"
+TEST(parseOverrunIsNotInvalidFormat) {
+    std::string content;
+    for (int frame = 0; frame < 2000; ++frame) {
+        content += "30\nframe " + std::to_string(frame) + "\n";
+        for (int atom = 0; atom < 30; ++atom) {
+            content += "C " + std::to_string(atom * 1.5) + " 0.000000 0.000000\n";
+        }
+    }
+    const std::string logPath = testDir() + "/budget.log";
+    g_logger.initialize(logPath);
+    g_logger.setLogToFile(true);
+    
+    const bool streamConversion = g_config.streamConversion;
+    g_config.streamConversion = false;
+    FrameSelection stride;
+    stride.stride = 2;
+    for (const FrameSelection& selection : {FrameSelection(), stride}) {
+        OutputFileWriter writer(writeBufferBytes());
+        createUniqueTempFile(writer);
+        StreamStats stats;
+        MemoryBudget budget(256 * 1024);
+        bool converted;
+        {
+            MemoryBudgetScope scope(budget, "budget_test");
+            converted = convertXYZToGaussianLog(content, writer, selection, stats, nullptr, nullptr);
+        }
+        CHECK(!converted);
+        CHECK(budget.exceeded());
+        writer.abandon();
+    }
+    g_config.streamConversion = streamConversion;
+    g_logger.setLogToFile(false);
+    
+    std::string log = readTestFile(logPath);
+    CHECK(log.find("memory budget during parse") != std::string::npos);
+    CHECK(log.find("Invalid XYZ format") == std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,51 @@
+// test_parallel.cpp - parallelFor与常驻线程池：结果完整、异常传播、嵌套调用，以及重复调用不再创建线程
+#include "test_common.h"
+
+TEST(coversEveryIndexOnce) {
+    for (size_t grain : {1, 3, 64}) {
+        std::vector<std::atomic<int>> hits(1000);
+        parallelFor(hits.size(), 8, grain, [&](size_t i) { hits[i].fetch_add(1); });
+        bool once = true;
+        for (auto& hit : hits) once = once && hit.load() == 1;
+        CHECK(once);
+    }
+}
+
+TEST(rethrowsWorkerException) {
+    std::atomic<size_t> done(0);
+    bool caught = false;
+    try {
+        parallelFor(10000, 4, 1, [&](size_t i) {
+            if (i == 5000) throw std::runtime_error("boom");
+            done.fetch_add(1);
+        });
+    } catch (const std::runtime_error& e) {
+        caught = std::string(e.what()) == "boom";
+    }
+    CHECK(caught);
+    CHECK(done.load() < 10000);
+}
+
+// 外层占满池中线程时内层由调用线程完成，不会死锁
+TEST(nestedCallsComplete) {
+    std::atomic<size_t> total(0);
+    parallelFor(16, 8, 1, [&](size_t) {
+        parallelFor(100, 8, 1, [&](size_t) { total.fetch_add(1); });
+    });
+    CHECK(total.load() == 1600);
+}
+
+TEST(reusesPoolThreads) {
+    std::atomic<size_t> total(0);
+    parallelFor(64, 4, 1, [&](size_t) { total.fetch_add(1); });
+    size_t threads = workerPool().threadCount();
+    for (int round = 0; round < 200; ++round) {
+        parallelFor(64, 4, 1, [&](size_t) { total.fetch_add(1); });
+    }
+    CHECK(total.load() == 64 * 201);
+    CHECK(workerPool().threadCount() == threads);
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,66 @@
+// test_temp_files.cpp - 临时文件回收：停止时同步删除尚未到期、等待就绪、退避重试中的文件，
+// 以及停止时回收线程正在处理的文件
+#include "test_common.h"
+
+namespace {
+
+bool exists(const std::string& path) {
+    std::error_code ec;
+    return std::filesystem::exists(path, ec);
+}
+
+} // namespace
+
+TEST(stopDeletesPendingFiles) {
+    std::string delayed = writeTestFile("delayed.log", "delayed");
+    std::string waiting = writeTestFile("waiting.log", "waiting");
+    {
+        TempFileReaper reaper;
+        reaper.start();
+        reaper.schedule(delayed, std::chrono::hours(1));
+        reaper.schedule(waiting, std::chrono::hours(1), []() { return false; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(exists(delayed) && exists(waiting));
+    }
+    CHECK(!exists(delayed));
+    CHECK(!exists(waiting));
+}
+
+// 非空目录无法删除，任务进入退避重试；停止前清空目录后，停止时的同步删除完成它
+TEST(stopDeletesRetryingFiles) {
+    std::string busy = testDir() + "/busy";
+    std::filesystem::create_directories(busy);
+    std::string inner = writeTestFile("busy/inner.log", "inner");
+    
+    TempFileReaper reaper;
+    reaper.start();
+    reaper.schedule(busy, std::chrono::milliseconds(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CHECK(exists(busy));
+    
+    std::filesystem::remove(inner);
+    reaper.stop();
+    CHECK(!exists(busy));
+}
+
+// 停止时回收线程正在检查就绪：线程放回的任务也在停止时删除
+TEST(stopDeletesFileBeingProcessed) {
+    std::string checking = writeTestFile("checking.log", "checking");
+    std::atomic<bool> entered(false);
+    TempFileReaper reaper;
+    reaper.start();
+    reaper.schedule(checking, std::chrono::hours(1), [&entered]() {
+        entered.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return false;
+    });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+    reaper.stop();
+    CHECK(!exists(checking));
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,120 @@
+// test_trajectory_file.cpp - 文件路径模式：从剪贴板文本识别轨迹文件路径（引号、file://URI、非路径文本），
+// 以及映射.xyz文件转换与把同一内容作为文本转换得到逐字节相同的Gaussian log
+#include "test_common.h"
+
+namespace {
+
+std::string generateTrajectory(size_t frames) {
+    std::string content;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        content += "3\nframe " + std::to_string(frame) + "\n";
+        content += "O " + std::to_string(frame * 0.01) + " 0.000000 0.117300\n";
+        content += "H 0.000000 0.757200 " + std::to_string(-0.4692 - frame * 1e-4) + "\n";
+        content += "H 0.000000 -0.757200 -0.469200\n";
+    }
+    return content;
+}
+
+std::string convertText(std::string_view content, const FrameSelection& selection) {
+    OutputFileWriter writer(writeBufferBytes());
+    std::string path = createUniqueTempFile(writer);
+    StreamStats stats;
+    FormatGuess guess = sniffFormat(content);
+    if (path.empty() || !convertContentToGaussianLog(content, guess.format, writer, selection, stats)) {
+        return "";
+    }
+    return readTestFile(path);
+}
+
+std::string convertPath(const std::string& file, const FrameSelection& selection) {
+    OutputFileWriter writer(writeBufferBytes());
+    std::string path = createUniqueTempFile(writer);
+    StreamStats stats;
+    if (path.empty() || !convertTrajectoryFileToGaussianLog(file, writer, selection, stats)) {
+        return "";
+    }
+    return readTestFile(path);
+}
+
+} // namespace
+
+TEST(recognizesPlainAndQuotedPaths) {
+    std::string path = writeTestFile("water.xyz", generateTrajectory(2));
+    CHECK(trajectoryPathFromText(path) == path);
+    CHECK(trajectoryPathFromText("  " + path + "\r\n") == path);
+    CHECK(trajectoryPathFromText("\"" + path + "\"") == path);
+    CHECK(trajectoryPathFromText("\t\"" + path + "\"\n") == path);
+    
+    std::string upper = writeTestFile("WATER.XYZ", generateTrajectory(1));
+    CHECK(trajectoryPathFromText(upper) == upper);
+}
+
+// file://URI：%XX解码（空格、非ASCII字节），无效的转义原样保留
+TEST(decodesFileUris) {
+    std::string spaced = writeTestFile("my water.xyz", generateTrajectory(1));
+    std::string encoded = "file://" + testDir() + "/my%20water.xyz";
+    CHECK(trajectoryPathFromText(encoded) == spaced);
+    CHECK(trajectoryPathFromText(encoded + "\n") == spaced);
+    
+    std::string accented = writeTestFile("caf\xC3\xA9.xyz", generateTrajectory(1));
+    CHECK(trajectoryPathFromText("file://" + testDir() + "/caf%C3%A9.xyz") == accented);
+    
+    std::string percent = writeTestFile("100%zz.xyz", generateTrajectory(1));
+    CHECK(trajectoryPathFromText("file://" + testDir() + "/100%zz.xyz") == percent);
+}
+
+// .xyzb按魔数识别，与扩展名无关
+TEST(recognizesBinaryTrajectoryByMagic) {
+    BinaryTrajectoryWriter writer(false);
+    CHECK(writer.create() && writer.append(readMultiXYZ(generateTrajectory(3))) && writer.finish());
+    std::string renamed = testDir() + "/trajectory.bin";
+    std::filesystem::copy_file(writer.filePath(), renamed, std::filesystem::copy_options::overwrite_existing);
+    CHECK(trajectoryPathFromText(renamed) == renamed);
+}
+
+TEST(rejectsNonPathText) {
+    std::string path = writeTestFile("water.xyz", generateTrajectory(2));
+    std::string text = writeTestFile("notes.txt", "3\ncomment\nO 0 0 0\n");
+    
+    CHECK(trajectoryPathFromText("").empty());
+    CHECK(trajectoryPathFromText(" \r\n\t").empty());
+    CHECK(trajectoryPathFromText(generateTrajectory(2)).empty());
+    CHECK(trajectoryPathFromText(path + "\n" + path).empty());
+    CHECK(trajectoryPathFromText(testDir() + "/missing.xyz").empty());
+    CHECK(trajectoryPathFromText(testDir()).empty());
+    CHECK(trajectoryPathFromText(text).empty());
+    CHECK(trajectoryPathFromText("\"" + path).empty());
+    CHECK(trajectoryPathFromText(std::string(5000, ' ') + path).empty());
+}
+
+// 映射文件与文本两条路径的结果逐字节相同：整体与流式转换，以及有帧选择时
+TEST(mappedFileMatchesTextConversion) {
+    const std::string content = generateTrajectory(500);
+    std::string path = writeTestFile("long.xyz", content);
+    FrameSelection stride;
+    stride.stride = 7;
+    FrameSelection last;
+    last.lastN = 20;
+    
+    const bool streamConversion = g_config.streamConversion;
+    for (bool stream : {false, true}) {
+        g_config.streamConversion = stream;
+        for (const FrameSelection& selection : {FrameSelection(), stride, last}) {
+            std::string expected = convertText(content, selection);
+            CHECK(!expected.empty());
+            CHECK(convertPath(path, selection) == expected);
+        }
+    }
+    g_config.streamConversion = streamConversion;
+    
+    std::string crlf;
+    for (char c : content) {
+        if (c == '\n') crlf += '\r';
+        crlf += c;
+    }
+    CHECK(convertPath(writeTestFile("long_crlf.xyz", crlf), FrameSelection()) == convertText(crlf, FrameSelection()));
+}
+
+int main(int argc, char** argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,108 @@
+// xyz_alloc_hook.cpp - 转换内存预算的分配钩子：替换全局operator new/delete，在每块内存前记录大小及所属预算，
+// 分配时把大小计入当前线程的活动预算（见xyz_core.h的内存记账）。
+// 只由可执行程序（托盘程序、xyzconv、xyzbench与测试）显式链接，不在libxyzcore.a中，
+// 链接核心库的其他程序不承担分配头部与计数的开销；未链接时MemoryBudget不统计也不限制
+#include "xyz_core.h"
+
+namespace {
+
+// 每块内存前的头部：16字节，保持malloc的对齐
+struct AllocationHeader {
+    uint64_t size;
+    uint32_t slot;
+    uint32_t generation;
+};
+static_assert(sizeof(AllocationHeader) == 16, "unexpected allocation header size");
+
+constexpr uint32_t NO_BUDGET_SLOT = 0xFFFFFFFFu;
+
+void* trackedAllocate(size_t size, bool nothrow) {
+    MemoryBudget* budget = t_activeBudget;
+    MemoryBudgetSlot* slot = nullptr;
+    if (budget) {
+        slot = &memoryBudgetSlot(budget->slotIndex());
+        if (!chargeMemoryBudget(*slot, size)) {
+            if (nothrow) return nullptr;
+            throw std::bad_alloc();
+        }
+    }
+
+    void* block = std::malloc(size + sizeof(AllocationHeader));
+    if (!block) {
+        if (slot) slot->live.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        if (nothrow) return nullptr;
+        throw std::bad_alloc();
+    }
+
+    AllocationHeader* header = static_cast<AllocationHeader*>(block);
+    header->size = size;
+    header->slot = budget ? budget->slotIndex() : NO_BUDGET_SLOT;
+    header->generation = budget ? budget->slotGeneration() : 0;
+    return header + 1;
+}
+
+// 块所属的预算仍是分配时的那一个（代号相同）时才减去活跃字节数
+void trackedFree(void* block) {
+    if (!block) return;
+    AllocationHeader* header = static_cast<AllocationHeader*>(block) - 1;
+    if (header->slot != NO_BUDGET_SLOT) {
+        MemoryBudgetSlot& slot = memoryBudgetSlot(header->slot);
+        if (slot.generation.load(std::memory_order_acquire) == header->generation) {
+            slot.live.fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+        }
+    }
+    std::free(header);
+}
+
+// 链接了本文件的程序中MemoryBudget才占用槽并统计
+const bool accountingEnabled = (enableMemoryAccounting(), true);
+
+}  // namespace
+
+void* operator new(size_t size) {
+    return trackedAllocate(size, false);
+}
+
+void* operator new[](size_t size) {
+    return trackedAllocate(size, false);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return trackedAllocate(size, true);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return trackedAllocate(size, true);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* block) noexcept {
+    trackedFree(block);
+}
+
+void operator delete[](void* block) noexcept {
+    trackedFree(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    trackedFree(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    trackedFree(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+    trackedFree(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    trackedFree(block);
+}
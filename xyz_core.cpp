@@ -0,0 +1,3746 @@
+// xyz_core.cpp - 转换核心的实现（见xyz_core.h）
+#include "xyz_core.h"
+
+#ifndef _WIN32
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+// 全局日志实例
+Logger g_logger;
+
+const char* Logger::levelTag(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG:   return "[DEBUG] ";
+        case LogLevel::INFO:    return "[INFO]  ";
+        case LogLevel::WARNING: return "[WARN]  ";
+        case LogLevel::ERROR:   return "[ERROR] ";
+    }
+    return "";
+}
+
+size_t Logger::composeText(char* out, size_t capacity, LogLevel level, std::string_view message,
+                           const char* file, int line) {
+    size_t length = std::min(message.size(), capacity);
+    std::memcpy(out, message.data(), length);
+    if (length < message.size() && capacity >= 3) {
+        std::memcpy(out + capacity - 3, "...", 3);
+        return capacity;
+    }
+    
+    if (file && line > 0 && (level >= LogLevel::WARNING)) {
+        // 只提取文件名，不包含完整路径
+        std::string_view filename(file);
+        size_t lastSlash = filename.find_last_of("/\\");
+        if (lastSlash != std::string_view::npos) {
+            filename.remove_prefix(lastSlash + 1);
+        }
+        int written = std::snprintf(out + length, capacity + 1 - length, " (%.*s:%d)",
+                                    static_cast<int>(filename.size()), filename.data(), line);
+        if (written > 0) {
+            length = std::min(capacity, length + static_cast<size_t>(written));
+        }
+    }
+    return length;
+}
+
+const char* Logger::stamp(std::time_t time) {
+    if (time != cachedSecond) {
+        cachedSecond = time;
+        std::tm* tm = std::localtime(&time);
+        if (!tm || std::strftime(cachedStamp, sizeof(cachedStamp), "[%Y-%m-%d %H:%M:%S] ", tm) == 0) {
+            cachedStamp[0] = '\0';
+        }
+    }
+    return cachedStamp;
+}
+
+void Logger::appendLine(LogLevel level, std::time_t time, std::string_view text) {
+    const char* timestamp = stamp(time);
+    if (logToConsole) {
+        if (level >= LogLevel::ERROR) {
+            writeConsole();
+            std::cerr << timestamp << levelTag(level) << text << '\n';
+        } else {
+            consoleBatch.append(timestamp).append(levelTag(level)).append(text).push_back('\n');
+        }
+    }
+    if (logToFile && logFile.is_open()) {
+        fileBatch.append(timestamp).append(levelTag(level)).append(text).push_back('\n');
+    }
+}
+
+void Logger::writeConsole() {
+    if (!consoleBatch.empty()) {
+        std::cout.write(consoleBatch.data(), static_cast<std::streamsize>(consoleBatch.size()));
+        std::cout.flush();
+        consoleBatch.clear();
+    }
+}
+
+void Logger::writeBatches(bool flushFile) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    writeConsole();
+    std::cerr.flush();
+    if (!fileBatch.empty() && logFile.is_open()) {
+        logFile.write(fileBatch.data(), static_cast<std::streamsize>(fileBatch.size()));
+    }
+    fileBatch.clear();
+    if (flushFile && logFile.is_open()) {
+        logFile.flush();
+    }
+}
+
+bool Logger::tryEnqueue(LogLevel level, std::string_view message, const char* file, int line) {
+    const size_t mask = RING_CAPACITY - 1;
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Record* record;
+    for (;;) {
+        record = &ring[pos & mask];
+        size_t sequence = record->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // 已满
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    
+    record->time = std::time(nullptr);
+    record->level = level;
+    record->length = static_cast<uint32_t>(composeText(record->text, RECORD_TEXT - 1, level, message, file, line));
+    record->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+size_t Logger::drain(bool& sawError) {
+    const size_t mask = RING_CAPACITY - 1;
+    size_t count = 0;
+    std::lock_guard<std::mutex> lock(outputMutex);
+    for (;;) {
+        Record& record = ring[dequeuePos & mask];
+        size_t sequence = record.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePos + 1) < 0) break;
+        
+        appendLine(record.level, record.time, std::string_view(record.text, record.length));
+        sawError = sawError || record.level >= LogLevel::ERROR;
+        record.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        ++dequeuePos;
+        ++count;
+    }
+    return count;
+}
+
+void Logger::run() {
+    auto lastFlush = std::chrono::steady_clock::now();
+    bool dirty = false;
+    for (;;) {
+        uint64_t requested = flushRequests.load(std::memory_order_acquire);
+        bool stopping = stopRequested.load(std::memory_order_acquire);
+        bool sawError = false;
+        size_t drained = drain(sawError);
+        
+        size_t dropped = droppedRecords.exchange(0);
+        if (dropped > 0) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            appendLine(LogLevel::WARNING, std::time(nullptr),
+                       std::to_string(dropped) + " log message(s) dropped because the log queue was full");
+            drained += 1;
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        dirty = dirty || drained > 0;
+        bool flushDue = dirty && now - lastFlush >= std::chrono::milliseconds(FLUSH_INTERVAL_MS);
+        bool flushFile = sawError || flushDue || stopping || requested != flushesCompleted;
+        if (drained > 0 || flushFile) {
+            writeBatches(flushFile);
+            if (flushFile) {
+                dirty = false;
+                lastFlush = now;
+            }
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            flushesCompleted = requested;
+            flushed.notify_all();
+        }
+        if (stopping) break;
+        
+        if (drained == 0) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            flusherIdle.store(true);
+            wakeup.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS), [this, requested] {
+                return stopRequested.load() || flushRequests.load() != requested || hasPending();
+            });
+            flusherIdle.store(false);
+        }
+    }
+}
+
+void Logger::logSync(LogLevel level, std::string_view message, const char* file, int line) {
+    std::string text(message.size() + 300, '\0');
+    text.resize(composeText(&text[0], text.size() - 1, level, message, file, line));
+    std::lock_guard<std::mutex> lock(outputMutex);
+    appendLine(level, std::time(nullptr), text);
+    writeConsole();
+    if (!fileBatch.empty() && logFile.is_open()) {
+        logFile.write(fileBatch.data(), static_cast<std::streamsize>(fileBatch.size()));
+        logFile.flush();
+    }
+    fileBatch.clear();
+}
+
+Logger::~Logger() {
+    shutdown();
+    if (logFile.is_open()) {
+        logFile.close();
+    }
+}
+
+bool Logger::initialize(const std::string& logFilePath, LogLevel level) {
+    currentLevel = level;
+    
+    // 创建日志目录
+    std::filesystem::path logPath(logFilePath);
+    if (logPath.has_parent_path()) {
+        try {
+            std::filesystem::create_directories(logPath.parent_path());
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to create log directory: " << e.what() << std::endl;
+        }
+    }
+    
+    logFile.open(logFilePath, std::ios::app);
+    if (!logFile.is_open()) {
+        std::cerr << "Failed to open log file: " << logFilePath << std::endl;
+        logToFile = false;
+        return false;
+    }
+    
+    // 写入启动分隔符
+    auto now = std::time(nullptr);
+    auto* tm = std::localtime(&now);
+    logFile << "\n========================================\n";
+    logFile << "XYZ Monitor started at: " << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << "\n";
+    logFile << "========================================\n";
+    logFile.flush();
+    
+    return true;
+}
+
+void Logger::log(LogLevel level, const std::string& message, const char* file, int line) {
+    if (!isEnabled(level)) return;
+    
+    // 先登记为生产者再检查异步模式：shutdown()关闭异步模式后等待已登记的生产者写完记录，
+    // 之后的日志都走同步输出，不会在最后一次取出之后才入队而丢失
+    activeProducers.fetch_add(1);
+    if (!asyncRunning.load()) {
+        activeProducers.fetch_sub(1);
+        logSync(level, message, file, line);
+        return;
+    }
+    
+    bool enqueued = true;
+    while (!tryEnqueue(level, message, file, line)) {
+        // 错误消息总是等待空位，不会被丢弃
+        if (level < LogLevel::ERROR && !blockWhenFull.load(std::memory_order_relaxed)) {
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            enqueued = false;
+            break;
+        }
+        wakeup.notify_one();
+        std::this_thread::yield();
+    }
+    activeProducers.fetch_sub(1);
+    if (!enqueued) return;
+    
+    // 错误可能紧接着导致退出，等待写出
+    if (level >= LogLevel::ERROR) {
+        flush();
+    } else {
+        wakeFlusher();
+    }
+}
+
+void Logger::startAsync(bool blockOnFull) {
+    blockWhenFull = blockOnFull;
+    if (asyncRunning.load()) return;
+    
+    if (!ring) {
+        ring.reset(new Record[RING_CAPACITY]);
+    }
+    for (size_t i = 0; i < RING_CAPACITY; ++i) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0);
+    dequeuePos = 0;
+    stopRequested = false;
+    flusher = std::thread(&Logger::run, this);
+    asyncRunning.store(true, std::memory_order_release);
+}
+
+void Logger::flush() {
+    if (!asyncRunning.load(std::memory_order_acquire) || std::this_thread::get_id() == flusher.get_id()) return;
+    
+    uint64_t target = flushRequests.fetch_add(1) + 1;
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wakeup.notify_one();
+    flushed.wait_for(lock, std::chrono::seconds(5), [this, target] {
+        return flushesCompleted >= target || !asyncRunning.load();
+    });
+}
+
+void Logger::shutdown() {
+    if (!asyncRunning.exchange(false)) return;
+    
+    // 等待仍在入队的生产者（输出线程继续取出，缓冲区满时不会卡住），此后的日志都同步输出
+    while (activeProducers.load() > 0) {
+        wakeup.notify_one();
+        std::this_thread::yield();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopRequested = true;
+        flushed.notify_all();
+    }
+    wakeup.notify_one();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    
+    // 输出线程最后一次取出之后发布的记录
+    bool sawError = false;
+    if (drain(sawError) > 0) {
+        writeBatches(true);
+    }
+}
+
+void Logger::logf(LogLevel level, const char* file, int line, const char* format, ...) {
+    if (!isEnabled(level)) return;
+    
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return;
+    
+    if (static_cast<size_t>(length) < sizeof(buffer)) {
+        log(level, std::string(buffer, static_cast<size_t>(length)), file, line);
+        return;
+    }
+    
+    std::string message(static_cast<size_t>(length), '\0');
+    va_start(args, format);
+    std::vsnprintf(&message[0], message.size() + 1, format, args);
+    va_end(args);
+    log(level, message, file, line);
+}
+
+// 全局配置；g_configMutex保护loadConfig的整体替换与snapshotConfig的复制
+Config g_config;
+static std::mutex g_configMutex;
+
+std::shared_ptr<const Config> snapshotConfig() {
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    return std::make_shared<const Config>(g_config);
+}
+
+// ===== 内存记账：预算槽表（全局operator new/delete在xyz_alloc_hook.cpp中） =====
+
+static MemoryBudgetSlot g_memoryBudgetSlots[MEMORY_BUDGET_SLOTS];
+static std::atomic<bool> g_memoryAccounting{false};
+
+void enableMemoryAccounting() {
+    g_memoryAccounting.store(true, std::memory_order_release);
+}
+
+bool memoryAccountingEnabled() {
+    return g_memoryAccounting.load(std::memory_order_acquire);
+}
+
+// 占用一个空闲槽；没有链接分配钩子时返回nullptr，槽用完时记录警告并返回nullptr（该预算不统计也不限制）
+MemoryBudgetSlot* acquireMemoryBudgetSlot(int64_t limit, uint32_t& generation) {
+    if (!memoryAccountingEnabled()) return nullptr;
+    for (MemoryBudgetSlot& slot : g_memoryBudgetSlots) {
+        bool expected = false;
+        if (!slot.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) continue;
+        slot.live.store(0, std::memory_order_relaxed);
+        slot.peak.store(0, std::memory_order_relaxed);
+        slot.stagePeak.store(0, std::memory_order_relaxed);
+        slot.allocations.store(0, std::memory_order_relaxed);
+        slot.allocatedBytes.store(0, std::memory_order_relaxed);
+        slot.limit = limit;
+        slot.exceeded.store(false, std::memory_order_relaxed);
+        slot.stage.store(nullptr, std::memory_order_relaxed);
+        slot.exceededStage = nullptr;
+        generation = slot.generation.fetch_add(1, std::memory_order_release) + 1;
+        return &slot;
+    }
+    LOG_WARNINGF("All %u memory budget slots are in use; this conversion runs without memory tracking "
+                 "or the max_memory_mb limit", static_cast<unsigned>(MEMORY_BUDGET_SLOTS));
+    return nullptr;
+}
+
+// 释放槽：代号递增，之后释放的旧块不再计入
+void releaseMemoryBudgetSlot(MemoryBudgetSlot* slot) {
+    if (!slot) return;
+    slot->generation.fetch_add(1, std::memory_order_release);
+    slot->inUse.store(false, std::memory_order_release);
+}
+
+MemoryBudgetSlot& memoryBudgetSlot(uint32_t index) {
+    return g_memoryBudgetSlots[index];
+}
+
+uint32_t MemoryBudget::slotIndex() const {
+    return static_cast<uint32_t>(slot - g_memoryBudgetSlots);
+}
+
+// 计入预算；超出上限时标记预算并返回false（只有第一次超出会失败）
+bool chargeMemoryBudget(MemoryBudgetSlot& slot, size_t size) {
+    int64_t bytes = static_cast<int64_t>(size);
+    int64_t live = slot.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (slot.limit > 0 && live > slot.limit && !slot.exceeded.exchange(true, std::memory_order_relaxed)) {
+        slot.exceededStage = slot.stage.load(std::memory_order_relaxed);
+        slot.live.fetch_sub(bytes, std::memory_order_relaxed);
+        return false;
+    }
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    
+    int64_t peak = slot.peak.load(std::memory_order_relaxed);
+    while (live > peak && !slot.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    int64_t stagePeak = slot.stagePeak.load(std::memory_order_relaxed);
+    while (live > stagePeak && !slot.stagePeak.compare_exchange_weak(stagePeak, live, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+void WorkerPool::help(Task& task) {
+    bool running;
+    {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        running = !task.closed;
+        if (running) ++task.active;
+    }
+    if (running) {
+        t_activeBudget = task.budget;
+        t_activeConfig = task.config;
+        task.run();
+        t_activeBudget = nullptr;
+        t_activeConfig = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++idle;
+    }
+    if (running) {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        if (--task.active == 0) task.finished.notify_all();
+    }
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&]() { return stopping || !queue.empty(); });
+        --idle;
+        if (stopping) return;
+        std::shared_ptr<Task> task = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        
+        help(*task);
+        task.reset();
+        lock.lock();
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+size_t WorkerPool::submit(const std::shared_ptr<Task>& task, size_t helpers) {
+    // 线程与队列节点在预算之外分配，分配失败也不会留下需要回收的线程
+    MemoryBudget* budget = t_activeBudget;
+    t_activeBudget = nullptr;
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        try {
+            while (idle < queue.size() + helpers && threads.size() < MAX_THREADS) {
+                threads.emplace_back(&WorkerPool::workerLoop, this);
+                ++idle;
+            }
+        } catch (const std::exception& e) {
+            LOG_WARNING("Cannot start worker thread, continuing with " + std::to_string(threads.size()) +
+                        ": " + std::string(e.what()));
+        }
+        
+        size_t available = idle > queue.size() ? idle - queue.size() : 0;
+        try {
+            for (; queued < std::min(helpers, available); ++queued) {
+                queue.push_back(task);
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    t_activeBudget = budget;
+    
+    for (size_t i = 0; i < queued; ++i) {
+        wake.notify_one();
+    }
+    return queued;
+}
+
+void WorkerPool::finish(const std::shared_ptr<Task>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.erase(std::remove(queue.begin(), queue.end(), task), queue.end());
+    }
+    std::unique_lock<std::mutex> lock(task->mutex);
+    task->closed = true;
+    task->finished.wait(lock, [&]() { return task->active == 0; });
+}
+
+void ConversionJobQueue::run() {
+    for (;;) {
+        ConversionDirection direction;
+        std::shared_ptr<ConversionProgress> progress;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) return;
+            direction = pending.front();
+            pending.pop_front();
+            progress = std::make_shared<ConversionProgress>();
+            current = progress;
+            currentDirection = direction;
+        }
+        notify();
+        
+        try {
+            ConfigScope configScope(snapshotConfig());
+            runner(direction, *progress);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception in conversion job: " + std::string(e.what()));
+        } catch (...) {
+            LOG_ERROR("Unknown exception in conversion job");
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current.reset();
+        }
+        notify();
+    }
+}
+
+void ConversionJobQueue::start(Runner jobRunner, StateCallback stateCallback) {
+    runner = std::move(jobRunner);
+    onStateChanged = std::move(stateCallback);
+    stopping = false;
+    worker = std::thread(&ConversionJobQueue::run, this);
+}
+
+bool ConversionJobQueue::submit(ConversionDirection direction) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (std::find(pending.begin(), pending.end(), direction) != pending.end()) {
+            return false;
+        }
+        pending.push_back(direction);
+    }
+    wakeup.notify_one();
+    notify();
+    return true;
+}
+
+bool ConversionJobQueue::cancelCurrent() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!current) return false;
+    current->cancelled.store(true);
+    return true;
+}
+
+ConversionJobQueue::Status ConversionJobQueue::status() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Status result;
+    result.queued = pending.size();
+    if (current) {
+        result.busy = true;
+        result.direction = currentDirection;
+        result.framesParsed = current->framesParsed.load();
+        result.framesWritten = current->framesWritten.load();
+    }
+    return result;
+}
+
+void ConversionJobQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending.clear();
+        if (current) current->cancelled.store(true);
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+std::string ConversionTrace::summary(int64_t total) const {
+    struct Stage {
+        const char* name;
+        int64_t duration;
+        size_t count;
+        size_t peakBytes;
+    };
+    std::vector<Stage> stages;
+    for (const Span& span : spans) {
+        auto found = std::find_if(stages.begin(), stages.end(), [&](const Stage& stage) {
+            return std::strcmp(stage.name, span.name) == 0;
+        });
+        if (found == stages.end()) {
+            stages.push_back({span.name, span.duration, 1, span.peakBytes});
+        } else {
+            found->duration += span.duration;
+            found->count++;
+            found->peakBytes = std::max(found->peakBytes, span.peakBytes);
+        }
+    }
+    
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << "Timing (" << name << "):";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        oss << (i == 0 ? " " : ", ") << stages[i].name << " " << stages[i].duration / 1000.0 << "ms";
+        if (stages[i].peakBytes > 0) {
+            oss << "/" << stages[i].peakBytes / (1024.0 * 1024.0) << "MB";
+        }
+        if (stages[i].count > 1) {
+            oss << " (" << stages[i].count << "x)";
+        }
+    }
+    oss << "; total " << total / 1000.0 << "ms";
+    return oss.str();
+}
+
+bool ConversionTrace::writeChromeTrace(const std::string& path, int64_t total) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    int64_t epochMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        wallClockStart.time_since_epoch()).count();
+    out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"conversion\":\"" << name
+        << "\",\"start_unix_us\":" << epochMicros << "},\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"xyz_monitor\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"" << name << "\"}},\n";
+    out << "{\"name\":\"" << name << "\",\"cat\":\"conversion\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0,\"dur\":"
+        << total << "}";
+    for (const Span& span : spans) {
+        out << ",\n{\"name\":\"" << span.name << "\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+            << span.start << ",\"dur\":" << span.duration;
+        if (span.peakBytes > 0) {
+            // 阶段峰值同时作为计数器事件，在时间线上显示为内存曲线
+            out << ",\"args\":{\"peak_bytes\":" << span.peakBytes << "}}";
+            out << ",\n{\"name\":\"memory\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":" << span.start
+                << ",\"args\":{\"peak_mb\":" << span.peakBytes / (1024.0 * 1024.0) << "}}";
+        } else {
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+void ConversionTrace::finish() {
+    if (finished) return;
+    finished = true;
+    int64_t total = now();
+    if (spans.empty()) return;
+    
+    LOG_INFO(summary(total));
+    if (!activeConfig().traceConversions) return;
+    
+    try {
+        std::error_code ec;
+        std::filesystem::create_directories(activeConfig().traceDir, ec);
+        
+        std::time_t seconds = std::chrono::system_clock::to_time_t(wallClockStart);
+        std::tm* tm = std::localtime(&seconds);
+        char stamp[32] = "";
+        if (tm) {
+            std::strftime(stamp, sizeof(stamp), "_%Y%m%d_%H%M%S", tm);
+        }
+        int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            wallClockStart.time_since_epoch()).count() % 1000);
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%03d.json", millis);
+        std::string path = (std::filesystem::path(activeConfig().traceDir) / (name + stamp + suffix)).string();
+        
+        if (writeChromeTrace(path, total)) {
+            LOG_DEBUG("Wrote conversion trace: " + path);
+        } else {
+            LOG_WARNING("Failed to write conversion trace: " + path);
+        }
+    } catch (const std::exception& e) {
+        LOG_WARNING("Exception writing conversion trace: " + std::string(e.what()));
+    }
+}
+
+// 工具函数：字符串修整
+std::string trim(const std::string& str) {
+    size_t first = str.find_first_not_of(' ');
+    if (std::string::npos == first) {
+        return str;
+    }
+    size_t last = str.find_last_not_of(' ');
+    return str.substr(first, (last - first + 1));
+}
+
+// 工具函数：字符串分割
+std::vector<std::string> split(const std::string& str, char delim) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(str);
+    std::string token;
+    while (std::getline(ss, token, delim)) {
+        std::string trimmed = trim(token);
+        if (!trimmed.empty()) {
+            tokens.push_back(trimmed);
+        }
+    }
+    return tokens;
+}
+
+// 工具函数：字符串修整（string_view版本，不复制；全空格行原样返回，与trim一致）
+std::string_view trimView(std::string_view str) {
+    size_t first = str.find_first_not_of(' ');
+    if (std::string_view::npos == first) {
+        return str;
+    }
+    size_t last = str.find_last_not_of(' ');
+    return str.substr(first, (last - first + 1));
+}
+
+// 工具函数：读取下一原始行（同std::getline，不修整、不跳过空行）
+bool nextRawLine(std::string_view text, size_t& pos, std::string_view& line) {
+    if (pos >= text.size()) return false;
+    
+    size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) end = text.size();
+    line = text.substr(pos, end - pos);
+    pos = end + 1;
+    return true;
+}
+
+// 工具函数：判断是否为空白字符（与istream >> std::string的分隔规则一致）
+inline bool isSpaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+// 工具函数：按空白切分（string_view版本，最多取maxTokens个，返回实际个数，不分配内存）
+size_t splitWhitespaceView(std::string_view str, std::string_view* tokens, size_t maxTokens) {
+    size_t count = 0;
+    size_t i = 0;
+    const size_t n = str.size();
+    while (count < maxTokens) {
+        while (i < n && isSpaceChar(str[i])) ++i;
+        if (i >= n) break;
+        size_t start = i;
+        while (i < n && !isSpaceChar(str[i])) ++i;
+        tokens[count++] = str.substr(start, i - start);
+    }
+    return count;
+}
+
+// 工具函数：解析浮点数（语义同std::stod：跳过前导空白、允许'+'号、接受最长有效前缀）
+bool parseDouble(std::string_view str, double& value) {
+    const char* first = str.data();
+    const char* last = str.data() + str.size();
+    while (first < last && isSpaceChar(*first)) ++first;
+    if (first < last && *first == '+') ++first;
+    
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc();
+}
+
+// 工具函数：解析整数（语义同std::stoi）
+bool parseInt(std::string_view str, int& value) {
+    const char* first = str.data();
+    const char* last = str.data() + str.size();
+    while (first < last && isSpaceChar(*first)) ++first;
+    if (first < last && *first == '+') ++first;
+    
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc();
+}
+
+// 工具函数：按6位小数、右对齐width宽度格式化浮点数，直接写入out，返回写入结束位置。
+// 输出与std::fixed << std::setprecision(6) << std::setw(width)逐字节一致；
+// out至少需要max(width, FIXED6_MAX_CHARS)字节
+char* formatFixed6(char* out, double value, int width) {
+    char digits[FIXED6_MAX_CHARS];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+    size_t length = static_cast<size_t>(result.ptr - digits);
+    
+    if (width > 0 && length < static_cast<size_t>(width)) {
+        size_t padding = static_cast<size_t>(width) - length;
+        std::memset(out, ' ', padding);
+        out += padding;
+    }
+    std::memcpy(out, digits, length);
+    return out + length;
+}
+
+// 工具函数：formatFixed6的精确输出长度，不实际格式化。整数部分的位数由数量级确定；
+// 舍入可能进位（如9.9999996输出10.000000）的值、极大值与非有限值实际格式化一次
+size_t fixed6Length(double value, int width) {
+    double magnitude = std::fabs(value);
+    if (magnitude < 1e15) {
+        size_t digits = 1;
+        double limit = 10.0;
+        while (magnitude >= limit) {
+            ++digits;
+            limit *= 10.0;
+        }
+        if (limit - magnitude > 1e-6) {
+            size_t length = (std::signbit(value) ? 1 : 0) + digits + 7;
+            return std::max(length, static_cast<size_t>(std::max(width, 0)));
+        }
+    }
+    char buffer[FIXED6_MAX_CHARS];
+    return static_cast<size_t>(formatFixed6(buffer, value, width) - buffer);
+}
+
+// 工具函数：十进制整数的字符数（含负号）
+inline size_t decimalLength(unsigned long long value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+inline size_t decimalLength(long long value) {
+    return value < 0 ? 1 + decimalLength(0ull - static_cast<unsigned long long>(value))
+                     : decimalLength(static_cast<unsigned long long>(value));
+}
+
+namespace {
+
+// 文本输出分两遍：同一段输出代码先用LengthSink求出精确字节数，分配一次目标缓冲区后
+// 再用PointerSink直接写入，两遍的长度由构造保证一致
+struct LengthSink {
+    size_t length = 0;
+    
+    template <size_t N>
+    void literal(const char (&)[N]) {
+        length += N - 1;
+    }
+    void text(std::string_view data) {
+        length += data.size();
+    }
+    void fill(char, size_t count) {
+        length += count;
+    }
+    void number(long long value) {
+        length += decimalLength(value);
+    }
+    void fixed6(double value, int width) {
+        length += fixed6Length(value, width);
+    }
+};
+
+struct PointerSink {
+    char* out;
+    
+    template <size_t N>
+    void literal(const char (&data)[N]) {
+        std::memcpy(out, data, N - 1);
+        out += N - 1;
+    }
+    void text(std::string_view data) {
+        std::memcpy(out, data.data(), data.size());
+        out += data.size();
+    }
+    void fill(char c, size_t count) {
+        std::memset(out, c, count);
+        out += count;
+    }
+    void number(long long value) {
+        out = std::to_chars(out, out + decimalLength(value), value).ptr;
+    }
+    void fixed6(double value, int width) {
+        out = formatFixed6(out, value, width);
+    }
+};
+
+}  // namespace
+
+// 解析配置的工作线程数（0表示按CPU核心数）
+unsigned resolveWorkerThreads(int configured) {
+    if (configured > 0) return static_cast<unsigned>(configured);
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+// 工具函数：64位xxHash（XXH64），一遍计算，用作剪贴板内容的缓存键
+inline uint64_t xxh64Rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t xxh64Read64(const unsigned char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;  // 小端平台
+}
+
+inline uint32_t xxh64Read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t xxh64(const void* data, size_t length, uint64_t seed) {
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+    auto round = [&](uint64_t acc, uint64_t input) {
+        acc += input * PRIME2;
+        return xxh64Rotl(acc, 31) * PRIME1;
+    };
+    
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    uint64_t hash;
+    
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round(v1, xxh64Read64(p));
+            v2 = round(v2, xxh64Read64(p + 8));
+            v3 = round(v3, xxh64Read64(p + 16));
+            v4 = round(v4, xxh64Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        
+        hash = xxh64Rotl(v1, 1) + xxh64Rotl(v2, 7) + xxh64Rotl(v3, 12) + xxh64Rotl(v4, 18);
+        for (uint64_t v : {v1, v2, v3, v4}) {
+            hash ^= round(0, v);
+            hash = hash * PRIME1 + PRIME4;
+        }
+    } else {
+        hash = seed + PRIME5;
+    }
+    
+    hash += static_cast<uint64_t>(length);
+    for (; p + 8 <= end; p += 8) {
+        hash ^= round(0, xxh64Read64(p));
+        hash = xxh64Rotl(hash, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        hash ^= static_cast<uint64_t>(xxh64Read32(p)) * PRIME1;
+        hash = xxh64Rotl(hash, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash ^= (*p) * PRIME5;
+        hash = xxh64Rotl(hash, 11) * PRIME1;
+    }
+    
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// 字符串转日志级别
+LogLevel stringToLogLevel(const std::string& levelStr) {
+    std::string upper = levelStr;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    
+    if (upper == "DEBUG") return LogLevel::DEBUG;
+    if (upper == "INFO") return LogLevel::INFO;
+    if (upper == "WARNING" || upper == "WARN") return LogLevel::WARNING;
+    if (upper == "ERROR") return LogLevel::ERROR;
+    
+    return LogLevel::INFO; // 默认
+}
+
+// 获取原子序数（不分配内存）。接受元素符号（不区分大小写）、带编号或后缀的标签
+// （如C12、Fe_a：开头两个字母是元素时取该元素，只有第二个字符不是字母时才按第一个字母取元素），
+// PDB式氢原子名（H后接大写字母，如HA、HB2，两个字母不是元素时按氢处理），
+// 以及直接写成数字的原子序数。无法识别时返回0（虚原子Bq、X、Gh等也返回0）
+int getAtomicNumber(std::string_view symbol) {
+    symbol = trimView(symbol);
+    if (symbol.empty()) return 0;
+    
+    if (std::isdigit(static_cast<unsigned char>(symbol[0])) || symbol[0] == '+') {
+        int number;
+        if (!parseInt(symbol, number) || number < 1 || number > MAX_ATOMIC_NUMBER) return 0;
+        return number;
+    }
+    
+    if (!std::isalpha(static_cast<unsigned char>(symbol[0]))) return 0;
+    if (symbol.size() == 1 || !std::isalpha(static_cast<unsigned char>(symbol[1]))) {
+        return lookupElement(symbol[0], 0);
+    }
+    
+    int number = lookupElement(symbol[0], symbol[1]);
+    if (number != 0) return number;
+    if (symbol[0] == 'H' && std::isupper(static_cast<unsigned char>(symbol[1]))) return 1;
+    return 0;
+}
+
+// 工具函数：解析帧区间 start:stop（从0开始，不含stop，两端均可省略）
+bool parseFrameRange(const std::string& value, FrameSelection& selection) {
+    std::string text = trim(value);
+    if (text.empty()) {
+        selection.start = 0;
+        selection.stop = 0;
+        return true;
+    }
+    size_t colon = text.find(':');
+    if (colon == std::string::npos) {
+        LOG_ERROR("Invalid frame range (expected start:stop): " + text);
+        return false;
+    }
+    
+    std::string startText = trim(text.substr(0, colon));
+    std::string stopText = trim(text.substr(colon + 1));
+    size_t start = startText.empty() ? 0 : std::stoull(startText);
+    size_t stop = stopText.empty() ? 0 : std::stoull(stopText);
+    if (stop > 0 && stop <= start) {
+        LOG_ERROR("Invalid frame range (stop must be greater than start): " + text);
+        return false;
+    }
+    selection.start = start;
+    selection.stop = stop;
+    return true;
+}
+
+// 工具函数：解析帧步长（正整数或auto）
+bool parseFrameStride(const std::string& value, FrameSelection& selection) {
+    std::string text = trim(value);
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "auto") {
+        selection.autoStride = true;
+        selection.stride = 1;
+        return true;
+    }
+    
+    int stride = std::stoi(text);
+    if (stride < 1) {
+        LOG_ERROR("Invalid frame stride: " + text);
+        return false;
+    }
+    selection.autoStride = false;
+    selection.stride = static_cast<size_t>(stride);
+    return true;
+}
+
+// 工具函数：解析帧选择描述，如 "stride=10,last=500,range=0:1000"；"all"或空表示全部帧
+bool parseFrameSelection(const std::string& spec, FrameSelection& selection) {
+    FrameSelection result;
+    std::string text = trim(spec);
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (!text.empty() && lower != "all") {
+        for (const std::string& item : split(text, ',')) {
+            size_t pos = item.find('=');
+            if (pos == std::string::npos) {
+                LOG_ERROR("Invalid frame selection item: " + item);
+                return false;
+            }
+            std::string key = trim(item.substr(0, pos));
+            std::string value = trim(item.substr(pos + 1));
+            
+            if (key == "range") {
+                if (!parseFrameRange(value, result)) return false;
+            } else if (key == "last") {
+                result.lastN = std::stoull(value);
+            } else if (key == "stride") {
+                if (!parseFrameStride(value, result)) return false;
+            } else {
+                LOG_ERROR("Unknown frame selection key: " + key);
+                return false;
+            }
+        }
+    }
+    selection = result;
+    return true;
+}
+
+// 读取配置文件
+bool loadConfig(const std::string& configFile) {
+    std::ifstream file(configFile);
+    if (!file.is_open()) {
+        // 创建默认配置文件
+        std::ofstream outFile(configFile);
+        if (outFile.is_open()) {
+            outFile << "hotkey=CTRL+SHIFT+V\n";
+            outFile << "hotkey_reverse=CTRL+SHIFT+G\n";
+            outFile << "gview_path=gview.exe\n";
+            outFile << "gaussian_clipboard_path=Clipboard.frg\n";
+            outFile << "# Re-parse the Gaussian clipboard file in the background whenever it changes\n";
+            outFile << "watch_gaussian_clipboard=true\n";
+            outFile << "temp_dir=temp\n";
+            outFile << "log_file=logs/xyz_monitor.log\n";
+            outFile << "log_level=INFO\n";
+            outFile << "log_to_console=true\n";
+            outFile << "log_to_file=true\n";
+            outFile << "# Write log messages from a background thread; when its queue is full either block or drop\n";
+            outFile << "log_async=true\n";
+            outFile << "log_queue_full=block\n";
+            outFile << "wait_seconds=5\n";
+            outFile << "# Delete the temp file once GView has finished opening it (wait_seconds becomes the upper bound)\n";
+            outFile << "delete_when_opened=false\n";
+            outFile << "# Memory budget in MB per conversion; conversions that exceed it are aborted (default: 500MB)\n";
+            outFile << "max_memory_mb=500\n";
+            outFile << "# Optional: set explicit character limit (0 = no limit)\n";
+            outFile << "max_clipboard_chars=0\n";
+            outFile << "# Parse clipboard text in place while holding the clipboard open until it is parsed; streamed conversions copy it first (false = always copy it once and release the clipboard immediately)\n";
+            outFile << "clipboard_borrow=true\n";
+            outFile << "# Worker threads for parsing (0 = auto, 1 = single-threaded)\n";
+            outFile << "worker_threads=0\n";
+            outFile << "# Stream frames to the temp file in bounded batches (max_memory_mb becomes a working-set cap)\n";
+            outFile << "stream_conversion=true\n";
+            outFile << "# Temp file write buffer in KB (rounded up to 4KB blocks)\n";
+            outFile << "write_buffer_kb=1024\n";
+            outFile << "# Frame selection for multi-frame XYZ: range (start:stop, 0-based, stop exclusive), then last N, then stride\n";
+            outFile << "frame_range=\n";
+            outFile << "frame_last=0\n";
+            outFile << "# Keep every Nth frame, or auto = smallest stride whose output fits max_memory_mb\n";
+            outFile << "frame_stride=1\n";
+            outFile << "# Alternate hotkey that converts with frame_selection_override instead (e.g. stride=10,last=500 or all)\n";
+            outFile << "hotkey_override=CTRL+SHIFT+ALT+V\n";
+            outFile << "frame_selection_override=all\n";
+            outFile << "# Reuse converted log files for identical clipboard content (0 disables the cache)\n";
+            outFile << "cache_max_mb=256\n";
+            outFile << "cache_max_entries=8\n";
+            outFile << "# Also cache parsed trajectories as binary .xyzb files (off, float32 or float64)\n";
+            outFile << "binary_cache=float32\n";
+            outFile << "# Write per-conversion stage timings as Chrome/Perfetto trace JSON files to trace_dir\n";
+            outFile << "trace_conversions=false\n";
+            outFile << "trace_dir=logs/traces\n";
+            outFile.close();
+            std::cout << "Created default config file: " << configFile << std::endl;
+        } else {
+            std::cerr << "Failed to create default config file: " << configFile << std::endl;
+        }
+        return false;
+    }
+    
+    // 在副本上解析，最后在锁内整体替换：后台线程取快照时不会读到改了一半的配置
+    Config config = g_config;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        
+        size_t pos = line.find('=');
+        if (pos != std::string::npos) {
+            std::string key = trim(line.substr(0, pos));
+            std::string value = trim(line.substr(pos + 1));
+            
+            try {
+                if (key == "hotkey") {
+                    config.hotkey = value;
+                } else if (key == "hotkey_reverse") {
+                    config.hotkeyReverse = value;
+                } else if (key == "gview_path") {
+                    config.gviewPath = value;
+                } else if (key == "gaussian_clipboard_path") {
+                    config.gaussianClipboardPath = value;
+                } else if (key == "watch_gaussian_clipboard") {
+                    config.watchGaussianClipboard = (value == "true" || value == "1");
+                } else if (key == "temp_dir") {
+                    config.tempDir = value;
+                } else if (key == "log_file") {
+                    config.logFile = value;
+                } else if (key == "log_level") {
+                    config.logLevel = value;
+                } else if (key == "log_to_console") {
+                    config.logToConsole = (value == "true" || value == "1");
+                } else if (key == "log_to_file") {
+                    config.logToFile = (value == "true" || value == "1");
+                } else if (key == "log_async") {
+                    config.logAsync = (value == "true" || value == "1");
+                } else if (key == "log_queue_full") {
+                    if (value != "block" && value != "drop") {
+                        LOG_WARNING("log_queue_full must be block or drop, using block");
+                    }
+                    config.logBlockWhenFull = (value != "drop");
+                } else if (key == "wait_seconds") {
+                    config.waitSeconds = std::stoi(value);
+                } else if (key == "delete_when_opened") {
+                    config.deleteWhenOpened = (value == "true" || value == "1");
+                } else if (key == "trace_conversions") {
+                    config.traceConversions = (value == "true" || value == "1");
+                } else if (key == "trace_dir") {
+                    config.traceDir = value;
+                } else if (key == "max_memory_mb") {
+                    config.maxMemoryMB = std::stoi(value);
+                    if (config.maxMemoryMB < 50) {
+                        LOG_WARNING("max_memory_mb is too small (" + std::to_string(config.maxMemoryMB) + "), setting to 50MB");
+                        config.maxMemoryMB = 50;
+                    }
+                } else if (key == "max_clipboard_chars") {
+                    size_t charLimit = std::stoull(value);
+                    config.maxClipboardChars = charLimit;
+                } else if (key == "clipboard_borrow") {
+                    config.clipboardBorrow = (value == "true" || value == "1");
+                } else if (key == "stream_conversion") {
+                    config.streamConversion = (value == "true" || value == "1");
+                } else if (key == "write_buffer_kb") {
+                    config.writeBufferKB = std::stoi(value);
+                    if (config.writeBufferKB < 64) {
+                        LOG_WARNING("write_buffer_kb is too small (" + std::to_string(config.writeBufferKB) + "), setting to 64KB");
+                        config.writeBufferKB = 64;
+                    }
+                } else if (key == "frame_range") {
+                    parseFrameRange(value, config.frameSelection);
+                } else if (key == "frame_last") {
+                    config.frameSelection.lastN = std::stoull(value);
+                } else if (key == "frame_stride") {
+                    parseFrameStride(value, config.frameSelection);
+                } else if (key == "hotkey_override") {
+                    config.hotkeyOverride = value;
+                } else if (key == "frame_selection_override") {
+                    parseFrameSelection(value, config.overrideSelection);
+                } else if (key == "cache_max_mb") {
+                    config.cacheMaxMB = std::max(0, std::stoi(value));
+                } else if (key == "cache_max_entries") {
+                    config.cacheMaxEntries = std::max(0, std::stoi(value));
+                } else if (key == "binary_cache") {
+                    if (value == "off" || value == "false" || value == "0") {
+                        config.binaryCacheBytes = 0;
+                    } else if (value == "float64") {
+                        config.binaryCacheBytes = 8;
+                    } else {
+                        if (value != "float32") {
+                            LOG_WARNING("binary_cache must be off, float32 or float64, using float32");
+                        }
+                        config.binaryCacheBytes = 4;
+                    }
+                } else if (key == "worker_threads") {
+                    config.workerThreads = std::stoi(value);
+                    if (config.workerThreads < 0) {
+                        LOG_WARNING("worker_threads cannot be negative, using automatic thread count");
+                        config.workerThreads = 0;
+                    }
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("Error parsing config value for key '" + key + "': " + std::string(e.what()));
+            }
+        }
+    }
+    file.close();
+    
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    g_config = std::move(config);
+    return true;
+}
+
+// 新增：解析Gaussian clipboard文件
+Trajectory parseGaussianClipboard(const std::string& filename) {
+    try {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            LOG_ERROR("Cannot open Gaussian clipboard file: " + filename);
+            return Trajectory();
+        }
+        
+        // 一次性读入整个文件，之后只在缓冲区切片上解析
+        std::string buffer;
+        file.seekg(0, std::ios::end);
+        std::streamoff fileSize = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (fileSize > 0) {
+            buffer.resize(static_cast<size_t>(fileSize));
+            file.read(&buffer[0], fileSize);
+            buffer.resize(static_cast<size_t>(file.gcount()));
+        }
+        file.close();
+        
+        return parseGaussianClipboardContent(buffer);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception reading Gaussian clipboard file: " + std::string(e.what()));
+        return Trajectory();
+    }
+}
+
+// 解析Gaussian clipboard（.frg）格式的文本：头部一行、原子数一行，之后每行为原子序数 x y z [标签]
+Trajectory parseGaussianClipboardContent(std::string_view content) {
+    Trajectory atoms;
+    
+    try {
+        size_t pos = 0;
+        std::string_view line;
+        
+        // 二进制方式读取，需要去掉行尾的'\r'（与文本模式getline一致）
+        auto readLine = [&]() {
+            if (!nextRawLine(content, pos, line)) return false;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            return true;
+        };
+        
+        // 跳过第一行（头部）
+        if (!readLine()) {
+            LOG_ERROR("Empty file or cannot read header");
+            return atoms;
+        }
+        
+        // 读取原子数量
+        if (!readLine()) {
+            LOG_ERROR("Cannot read number of atoms");
+            return atoms;
+        }
+        
+        int numAtoms;
+        if (!parseInt(line, numAtoms)) {
+            LOG_ERROR("Cannot parse number of atoms: " + std::string(line));
+            return atoms;
+        }
+        LOG_DEBUG("Expected number of atoms: " + std::to_string(numAtoms));
+        
+        if (numAtoms > 0) {
+            atoms.reserveAtoms(static_cast<size_t>(numAtoms));
+        }
+        atoms.beginFrame("Converted from Gaussian clipboard");
+        
+        // 读取原子数据
+        for (int i = 0; i < numAtoms; i++) {
+            if (!readLine()) {
+                LOG_WARNING("Expected " + std::to_string(numAtoms) + " atoms, but only found " + std::to_string(i));
+                break;
+            }
+            
+            // 原子序数 x y z [标签]
+            std::string_view parts[4];
+            int atomicNumber;
+            double x, y, z;
+            
+            if (splitWhitespaceView(line, parts, 4) == 4 &&
+                parseInt(parts[0], atomicNumber) &&
+                parseDouble(parts[1], x) && parseDouble(parts[2], y) && parseDouble(parts[3], z)) {
+                const char* symbol = elementSymbol(atomicNumber);
+                if (symbol) {
+                    atoms.addAtom(symbol, x, y, z);
+                    
+                    LOG_DEBUGF("Added atom %d: %s (%d) at (%f, %f, %f)",
+                               i + 1, symbol, atomicNumber, x, y, z);
+                } else {
+                    LOG_WARNING("Unknown atomic number " + std::to_string(atomicNumber) + " in line: " + std::string(line));
+                }
+            } else {
+                LOG_WARNING("Cannot parse atom data in line: " + std::string(line));
+            }
+        }
+        
+        if (atoms.pendingAtomCount() > 0) {
+            atoms.endFrame();
+        } else {
+            atoms.cancelFrame();
+        }
+        
+        LOG_INFO("Parsed " + std::to_string(atoms.totalAtoms()) + " atoms from Gaussian clipboard");
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception parsing Gaussian clipboard: " + std::string(e.what()));
+    }
+    
+    return atoms;
+}
+
+// 新增：创建XYZ字符串（输出轨迹中的一帧）
+namespace {
+
+template <typename Sink>
+void emitXYZFrame(Sink& sink, const Trajectory& trajectory, size_t frame) {
+    const std::vector<uint32_t>& elementIds = trajectory.frameElements(frame);
+    size_t begin = trajectory.frameOffsets[frame];
+    size_t count = trajectory.frameAtomCount(frame);
+    
+    sink.number(static_cast<long long>(count));
+    sink.literal("\nConverted from Gaussian clipboard\n");
+    for (size_t i = 0; i < count; ++i) {
+        // 元素符号左对齐占2列，坐标右对齐占12列
+        const std::string& symbol = trajectory.elements[elementIds[i]];
+        sink.text(symbol);
+        if (symbol.size() < 2) sink.fill(' ', 2 - symbol.size());
+        sink.literal(" ");
+        sink.fixed6(trajectory.x[begin + i], 12);
+        sink.literal(" ");
+        sink.fixed6(trajectory.y[begin + i], 12);
+        sink.literal(" ");
+        sink.fixed6(trajectory.z[begin + i], 12);
+        sink.literal("\n");
+    }
+}
+
+}  // namespace
+
+// 单帧XYZ文本的精确字节数
+size_t xyzFrameSize(const Trajectory& trajectory, size_t frame) {
+    LengthSink sink;
+    emitXYZFrame(sink, trajectory, frame);
+    return sink.length;
+}
+
+// 把单帧XYZ文本直接写入out（至少xyzFrameSize字节），返回写入结束位置
+char* formatXYZFrame(char* out, const Trajectory& trajectory, size_t frame) {
+    PointerSink sink{out};
+    emitXYZFrame(sink, trajectory, frame);
+    return sink.out;
+}
+
+std::string createXYZString(const Trajectory& trajectory, size_t frame) {
+    try {
+        std::string out(xyzFrameSize(trajectory, frame), '\0');
+        formatXYZFrame(&out[0], trajectory, frame);
+        return out;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception creating XYZ string: " + std::string(e.what()));
+        return "";
+    }
+}
+
+// 解析已切分的四个字段（元素 x y z）中的坐标，无法解析时返回false
+bool parseAtomFields(const std::string_view* parts, double& x, double& y, double& z) {
+    return parseDouble(parts[1], x) && parseDouble(parts[2], y) && parseDouble(parts[3], z);
+}
+
+// 读取单帧XYZ数据：countLine为原子数行，从游标继续读取注释行和原子行并追加到轨迹
+bool readXYZFrame(LineCursor& cursor, std::string_view countLine, Trajectory& trajectory) {
+    try {
+        int numAtoms;
+        if (!parseInt(countLine, numAtoms)) {
+            LOG_ERROR("Invalid atom count in readXYZFrame: " + std::string(countLine));
+            return false;
+        }
+        if (numAtoms <= 0) return false;
+        
+        std::string_view line;
+        trajectory.beginFrame(cursor.next(line) ? line : std::string_view());
+        
+        for (int i = 0; i < numAtoms; ++i) {
+            if (!cursor.next(line)) break;
+            
+            std::string_view parts[4];
+            if (splitWhitespaceView(line, parts, 4) >= 4) {
+                double x, y, z;
+                if (parseAtomFields(parts, x, y, z)) {
+                    trajectory.addAtom(parts[0], x, y, z);
+                } else {
+                    LOG_WARNINGF("Failed to parse atom at line %llu: invalid coordinate",
+                                 static_cast<unsigned long long>(cursor.lineIndex()));
+                }
+            }
+        }
+        
+        if (trajectory.pendingAtomCount() == 0) {
+            trajectory.cancelFrame();
+            return false;
+        }
+        trajectory.endFrame();
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in readXYZFrame: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 从游标继续读取标准格式的后续帧，直到数据结束或遇到无法读取的帧
+void readRemainingXYZFrames(LineCursor& cursor, Trajectory& trajectory, ConversionProgress* progress) {
+    std::string_view countLine;
+    while (!isCancelled(progress) && cursor.next(countLine)) {
+        size_t startLine = cursor.lineIndex();
+        if (!readXYZFrame(cursor, countLine, trajectory)) {
+            LOG_WARNING("Failed to read frame starting at line: " + std::to_string(startLine));
+            break;
+        }
+        if (progress) progress->framesParsed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// 边界扫描：只按原子数行跳过后续行，不切分坐标字段，建立帧索引。
+// 遇到无法作为原子数的行时停止（与串行读取时的停止位置一致），此时finished置为true；
+// maxAtoms非0时，累计原子行数达到该值后停止本次扫描（至少包含一帧），可从游标继续
+std::vector<FrameSpan> scanXYZFrameSpans(LineCursor& cursor, size_t maxAtoms, bool& finished) {
+    std::vector<FrameSpan> spans;
+    std::string_view line;
+    size_t scannedAtoms = 0;
+    finished = false;
+    while (!(maxAtoms > 0 && scannedAtoms >= maxAtoms)) {
+        if (!cursor.next(line)) {
+            finished = true;
+            break;
+        }
+
+        FrameSpan span;
+        span.countLine = cursor.lineIndex();
+        if (!parseInt(line, span.atomCount)) {
+            LOG_ERROR("Invalid atom count in readXYZFrame: " + std::string(line));
+            LOG_WARNING("Failed to read frame starting at line: " + std::to_string(span.countLine));
+            finished = true;
+            break;
+        }
+        if (span.atomCount <= 0) {
+            LOG_WARNING("Failed to read frame starting at line: " + std::to_string(span.countLine));
+            finished = true;
+            break;
+        }
+        span.begin = cursor.position();
+        span.atomLines = 0;
+        
+        if (cursor.next(line)) {
+            while (span.atomLines < static_cast<size_t>(span.atomCount) && cursor.next(line)) {
+                ++span.atomLines;
+            }
+        }
+        scannedAtoms += span.atomLines;
+        spans.push_back(span);
+    }
+    return spans;
+}
+
+// 从帧索引中按原子数预算取出下一批（至少一帧），next为下一个待取的下标
+std::vector<FrameSpan> takeFrameSpans(const std::vector<FrameSpan>& spans, size_t& next, size_t maxAtoms) {
+    std::vector<FrameSpan> batch;
+    size_t batchAtoms = 0;
+    while (next < spans.size() && (batch.empty() || batchAtoms < maxAtoms)) {
+        batchAtoms += spans[next].atomLines;
+        batch.push_back(spans[next++]);
+    }
+    return batch;
+}
+
+// 按帧选择过滤帧索引（见selectFrameIndices）
+std::vector<FrameSpan> selectFrameSpans(const std::vector<FrameSpan>& spans, const FrameSelection& selection,
+                                        size_t budgetAtoms, size_t& chosenStride) {
+    std::vector<size_t> indices = selectFrameIndices(spans.size(), [&](size_t i) { return spans[i].atomLines; },
+                                                     selection, budgetAtoms, chosenStride);
+    std::vector<FrameSpan> selected;
+    selected.reserve(indices.size());
+    for (size_t i : indices) {
+        selected.push_back(spans[i]);
+    }
+    return selected;
+}
+
+// 并行解析已建立索引的帧并按原顺序追加到轨迹。
+// 每帧按头部原子数预留坐标槽位，工作线程直接写入；之后串行压缩未填满的槽位并合并拓扑
+void parseXYZFramesParallel(std::string_view content, const std::vector<FrameSpan>& spans,
+                            Trajectory& trajectory, unsigned threads, ConversionProgress* progress) {
+    const size_t frameCount = spans.size();
+    const size_t base = trajectory.totalAtoms();
+    
+    std::vector<size_t> slotOffsets(frameCount + 1);
+    slotOffsets[0] = base;
+    for (size_t k = 0; k < frameCount; ++k) {
+        slotOffsets[k + 1] = slotOffsets[k] + spans[k].atomLines;
+    }
+    
+    const size_t totalSlots = slotOffsets[frameCount];
+    trajectory.x.resize(totalSlots);
+    trajectory.y.resize(totalSlots);
+    trajectory.z.resize(totalSlots);
+    std::vector<uint32_t> ids(totalSlots - base);
+    std::vector<size_t> parsedCounts(frameCount, 0);
+    std::vector<std::string> comments(frameCount);
+    // 拓扑中未登记的符号：(帧内原子下标, 符号)，合并时串行登记
+    std::vector<std::vector<std::pair<size_t, std::string_view>>> unknownSymbols(frameCount);
+    
+    const Trajectory& reference = trajectory;
+    parallelFor(frameCount, threads, 16, [&](size_t k) {
+        if (isCancelled(progress)) return;
+        const FrameSpan& span = spans[k];
+        LineCursor cursor(content, span.begin, span.countLine + 1);
+        std::string_view line;
+        if (cursor.next(line)) {
+            comments[k].assign(line.data(), line.size());
+        }
+        
+        size_t slot = slotOffsets[k];
+        size_t parsed = 0;
+        for (size_t i = 0; i < span.atomLines; ++i) {
+            cursor.next(line);
+            
+            std::string_view parts[4];
+            if (splitWhitespaceView(line, parts, 4) >= 4) {
+                double x, y, z;
+                if (parseAtomFields(parts, x, y, z)) {
+                    trajectory.x[slot + parsed] = x;
+                    trajectory.y[slot + parsed] = y;
+                    trajectory.z[slot + parsed] = z;
+                    uint32_t id = reference.findElement(parts[0], parsed);
+                    if (id == Trajectory::UNKNOWN_ELEMENT) {
+                        unknownSymbols[k].emplace_back(parsed, parts[0]);
+                    }
+                    ids[slot + parsed - base] = id;
+                    ++parsed;
+                } else {
+                    LOG_WARNINGF("Failed to parse atom at line %llu: invalid coordinate",
+                                 static_cast<unsigned long long>(cursor.lineIndex()));
+                }
+            }
+        }
+        parsedCounts[k] = parsed;
+        if (progress) progress->framesParsed.fetch_add(1, std::memory_order_relaxed);
+    });
+    
+    if (isCancelled(progress)) {
+        trajectory.x.resize(base);
+        trajectory.y.resize(base);
+        trajectory.z.resize(base);
+        return;
+    }
+    
+    // 按帧顺序合并；某帧没有任何原子时与串行读取一样在此停止
+    size_t writePos = base;
+    for (size_t k = 0; k < frameCount; ++k) {
+        size_t parsed = parsedCounts[k];
+        if (parsed == 0) {
+            LOG_WARNING("Failed to read frame starting at line: " + std::to_string(spans[k].countLine));
+            break;
+        }
+        
+        size_t slot = slotOffsets[k];
+        if (slot != writePos) {
+            std::copy(trajectory.x.begin() + slot, trajectory.x.begin() + slot + parsed, trajectory.x.begin() + writePos);
+            std::copy(trajectory.y.begin() + slot, trajectory.y.begin() + slot + parsed, trajectory.y.begin() + writePos);
+            std::copy(trajectory.z.begin() + slot, trajectory.z.begin() + slot + parsed, trajectory.z.begin() + writePos);
+        }
+        
+        uint32_t* frameIds = &ids[slot - base];
+        for (const auto& unknown : unknownSymbols[k]) {
+            frameIds[unknown.first] = trajectory.addElement(unknown.second);
+        }
+        
+        if (trajectory.topologies.empty() ||
+            !std::equal(frameIds, frameIds + parsed,
+                        trajectory.topologies.back().begin(), trajectory.topologies.back().end())) {
+            trajectory.topologies.emplace_back(frameIds, frameIds + parsed);
+        }
+        trajectory.frameTopology.push_back(static_cast<uint32_t>(trajectory.topologies.size() - 1));
+        trajectory.comments.push_back(std::move(comments[k]));
+        writePos += parsed;
+        trajectory.frameOffsets.push_back(writePos);
+    }
+    
+    trajectory.x.resize(writePos);
+    trajectory.y.resize(writePos);
+    trajectory.z.resize(writePos);
+}
+
+// 读取标准格式的后续帧：帧数足够多且允许多线程时先扫描边界再并行解析，否则逐帧串行读取
+void readXYZFrames(std::string_view content, LineCursor& cursor, Trajectory& trajectory,
+                   ConversionProgress* progress) {
+    unsigned threads = resolveWorkerThreads(activeConfig().workerThreads);
+    if (threads <= 1) {
+        readRemainingXYZFrames(cursor, trajectory, progress);
+        return;
+    }
+    
+    bool finished;
+    std::vector<FrameSpan> spans = scanXYZFrameSpans(cursor, 0, finished);
+    if (spans.empty()) return;
+    
+    LOG_DEBUG("Parsing " + std::to_string(spans.size()) + " indexed frames on " + std::to_string(threads) + " threads");
+    parseXYZFramesParallel(content, spans, trajectory, threads, progress);
+}
+
+// 融合的XYZ校验与解析：一次遍历完成格式判断和帧读取，遇到确定的拒绝原因立即返回。
+// 返回值表示内容是否为有效XYZ格式；trajectory为nullptr时只做校验（只读取判断所需的前几行）
+bool parseXYZContent(std::string_view content, Trajectory* trajectory, ConversionProgress* progress) {
+    try {
+        if (content.empty()) {
+            LOG_DEBUG("Content is empty");
+            return false;
+        }
+        
+        if (content.find('\0') != std::string_view::npos) {
+            LOG_DEBUG("Content contains binary data");
+            return false;
+        }
+        
+        LineCursor cursor(content);
+        std::string_view firstLine;
+        if (!cursor.next(firstLine)) {
+            LOG_DEBUG("No lines found in content");
+            return false;
+        }
+        
+        // 检查是否是标准XYZ格式（第一行是原子数）
+        int atomCount;
+        bool firstIsCount = parseInt(firstLine, atomCount);
+        if (firstIsCount && atomCount > 0 && atomCount <= 10000) {
+            // 读取第一帧的同时校验：行数不足优先于坐标行无效报告
+            std::string_view line;
+            bool enoughLines = cursor.next(line);
+            if (trajectory) {
+                trajectory->beginFrame(enoughLines ? line : std::string_view());
+            }
+            size_t invalidIndex = 0;
+            
+            for (int i = 0; i < atomCount && enoughLines; ++i) {
+                if (!cursor.next(line)) {
+                    enoughLines = false;
+                    break;
+                }
+                if (invalidIndex != 0 || (!trajectory && i >= 5)) continue;
+                
+                std::string_view parts[4];
+                size_t count = splitWhitespaceView(line, parts, 4);
+                double x, y, z;
+                bool parsed = count >= 4 && parseAtomFields(parts, x, y, z);
+                if (i < 5 && !parsed) {
+                    invalidIndex = static_cast<size_t>(i) + 2;
+                } else if (parsed && trajectory) {
+                    trajectory->addAtom(parts[0], x, y, z);
+                } else if (count >= 4 && trajectory) {
+                    LOG_WARNINGF("Failed to parse atom at line %llu: invalid coordinate",
+                                 static_cast<unsigned long long>(cursor.lineIndex()));
+                }
+            }
+            
+            if (!enoughLines || invalidIndex != 0) {
+                if (trajectory) {
+                    trajectory->cancelFrame();
+                }
+                if (!enoughLines) {
+                    LOG_DEBUG("Not enough lines for atom count: " + std::to_string(atomCount));
+                } else {
+                    LOG_DEBUG("Invalid coordinate line at index: " + std::to_string(invalidIndex));
+                }
+                return false;
+            }
+            LOG_DEBUG("Detected standard XYZ format");
+            
+            if (trajectory) {
+                LOG_DEBUG("Processing standard XYZ format");
+                trajectory->endFrame();
+                if (progress) progress->framesParsed.fetch_add(1, std::memory_order_relaxed);
+                readXYZFrames(content, cursor, *trajectory, progress);
+                LOG_INFO("Processed " + std::to_string(trajectory->frameCount()) + " frames");
+            }
+            return true;
+        }
+        
+        if (!firstIsCount) {
+            LOG_DEBUG("First line is not atom count, checking simplified format");
+        }
+        
+        // 简化格式：前5行必须都是坐标行
+        bool collect = trajectory && !firstIsCount;
+        if (collect) {
+            trajectory->beginFrame("Simplified XYZ format");
+        }
+        std::string_view line = firstLine;
+        bool hasLine = true;
+        for (size_t i = 0; hasLine && (collect || i < 5); ++i) {
+            std::string_view parts[4];
+            size_t count = splitWhitespaceView(line, parts, 4);
+            double x, y, z;
+            bool parsed = count >= 4 && parseAtomFields(parts, x, y, z);
+            if (i < 5 && !parsed) {
+                if (collect) {
+                    trajectory->cancelFrame();
+                }
+                LOG_DEBUG("Not recognized as XYZ format");
+                return false;
+            }
+            if (parsed) {
+                if (collect) trajectory->addAtom(parts[0], x, y, z);
+            } else if (count >= 4 && collect) {
+                LOG_WARNING("Failed to parse simplified format line: invalid coordinate");
+            }
+            hasLine = cursor.next(line);
+        }
+        LOG_DEBUG("Detected simplified XYZ format");
+        
+        if (trajectory) {
+            if (firstIsCount) {
+                // 首行可解析为整数（但超出原子数校验范围）时按标准格式读取
+                LOG_DEBUG("Processing standard XYZ format");
+                LineCursor restart(content);
+                readXYZFrames(content, restart, *trajectory, progress);
+            } else {
+                LOG_DEBUG("Processing simplified XYZ format");
+                trajectory->endFrame();
+            }
+            LOG_INFO("Processed " + std::to_string(trajectory->frameCount()) + " frames");
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in parseXYZContent: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 检查是否为XYZ格式（只校验，不保留帧数据）
+bool isXYZFormat(std::string_view content) {
+    return parseXYZContent(content, nullptr);
+}
+
+// 读取多帧XYZ数据
+Trajectory readMultiXYZ(std::string_view content) {
+    Trajectory trajectory;
+    if (!parseXYZContent(content, &trajectory)) {
+        return Trajectory();
+    }
+    return trajectory;
+}
+
+namespace {
+
+// 前缀中没有NUL字节时才可能是文本格式
+bool isTextPrefix(std::string_view prefix) {
+    return std::memchr(prefix.data(), '\0', prefix.size()) == nullptr;
+}
+
+// 标准XYZ的结构（与parseXYZContent的判断一致）：原子数行（1-10000）、注释行，之后前min(N,5)个原子行有效，
+// 前缀完整时原子行数也须足够。原子行在截断处之前用完时降低置信度。comment返回注释行
+int scoreStandardXYZ(std::string_view prefix, bool truncated, std::string_view& comment) {
+    LineCursor cursor(prefix);
+    std::string_view line;
+    int atomCount;
+    if (!cursor.next(line) || !parseInt(line, atomCount) || atomCount <= 0 || atomCount > 10000) return 0;
+    if (!cursor.next(comment)) return 0;
+    
+    int checked = std::min(atomCount, 5);
+    for (int i = 0; i < checked; ++i) {
+        if (!cursor.next(line)) return truncated && i > 0 ? 60 : 0;
+        
+        std::string_view parts[4];
+        double x, y, z;
+        if (splitWhitespaceView(line, parts, 4) < 4 || !parseAtomFields(parts, x, y, z)) return 0;
+    }
+    
+    if (!truncated) {
+        for (int i = checked; i < atomCount; ++i) {
+            if (!cursor.next(line)) return 0;
+        }
+    }
+    return 90;
+}
+
+int detectStandardXYZ(std::string_view prefix, bool truncated) {
+    if (!isTextPrefix(prefix)) return 0;
+    std::string_view comment;
+    return scoreStandardXYZ(prefix, truncated, comment);
+}
+
+// 扩展XYZ：标准XYZ结构，注释行带Properties=（首列为元素、随后为坐标，标准解析器只读前四列）或只有Lattice=
+int detectExtendedXYZ(std::string_view prefix, bool truncated) {
+    if (!isTextPrefix(prefix)) return 0;
+    std::string_view comment;
+    int score = scoreStandardXYZ(prefix, truncated, comment);
+    if (score == 0) return 0;
+    
+    size_t properties = comment.find("Properties=");
+    if (properties != std::string_view::npos) {
+        std::string_view layout = comment.substr(properties + 11);
+        if (!layout.empty() && layout.front() == '"') layout.remove_prefix(1);
+        return layout.compare(0, 19, "species:S:1:pos:R:3") == 0 ? score + 5 : 0;
+    }
+    return comment.find("Lattice=") != std::string_view::npos ? score + 5 : 0;
+}
+
+// 简化XYZ：没有原子数行，前5行（内容不足5行时为全部行）都是原子行
+int detectSimplifiedXYZ(std::string_view prefix, bool truncated) {
+    if (!isTextPrefix(prefix)) return 0;
+    LineCursor cursor(prefix);
+    std::string_view line;
+    int lines = 0;
+    while (lines < 5 && cursor.next(line)) {
+        std::string_view parts[4];
+        double x, y, z;
+        if (splitWhitespaceView(line, parts, 4) < 4 || !parseAtomFields(parts, x, y, z)) return 0;
+        ++lines;
+    }
+    if (lines == 0) return 0;
+    return lines == 5 || !truncated ? 80 : 50;
+}
+
+// Gaussian clipboard（.frg）：头部一行、原子数一行，之后每行为原子序数 x y z [标签]（与parseGaussianClipboardContent一致，
+// 未知的原子序数由解析器跳过，这里不拒绝）
+int detectGaussianClipboard(std::string_view prefix, bool truncated) {
+    if (!isTextPrefix(prefix)) return 0;
+    size_t pos = 0;
+    std::string_view line;
+    int atomCount;
+    if (!nextRawLine(prefix, pos, line) || !nextRawLine(prefix, pos, line) ||
+        !parseInt(line, atomCount) || atomCount <= 0) {
+        return 0;
+    }
+    
+    int checked = std::min(atomCount, 5);
+    for (int i = 0; i < checked; ++i) {
+        if (!nextRawLine(prefix, pos, line)) return i > 0 && truncated ? 60 : 0;
+        
+        std::string_view parts[4];
+        int atomicNumber;
+        double x, y, z;
+        if (splitWhitespaceView(line, parts, 4) < 4 || !parseInt(parts[0], atomicNumber) ||
+            atomicNumber <= 0 || !parseAtomFields(parts, x, y, z)) {
+            return 0;
+        }
+    }
+    return 85;
+}
+
+// Gaussian log：程序启动横幅或本程序写出的头部，或（复制了部分输出时）坐标块标题
+int detectGaussianLog(std::string_view prefix, bool /*truncated*/) {
+    if (!isTextPrefix(prefix)) return 0;
+    if (prefix.find("Entering Gaussian System") != std::string_view::npos ||
+        prefix.find("! This file was generated by XYZ Monitor") != std::string_view::npos) {
+        return 95;
+    }
+    if (prefix.find("Standard orientation:") != std::string_view::npos ||
+        prefix.find("Input orientation:") != std::string_view::npos) {
+        return 75;
+    }
+    return 0;
+}
+
+int detectBinaryTrajectory(std::string_view prefix, bool /*truncated*/) {
+    return isBinaryTrajectory(prefix) ? 100 : 0;
+}
+
+struct FormatDetectorEntry {
+    InputFormat format;
+    FormatDetector detector;
+};
+
+std::mutex g_formatDetectorMutex;
+
+// 检测器注册表（内置检测器按特异性从高到低排列，同分时先注册者优先）
+std::vector<FormatDetectorEntry>& formatDetectors() {
+    static std::vector<FormatDetectorEntry> detectors = {
+        {InputFormat::BinaryTrajectory, detectBinaryTrajectory},
+        {InputFormat::ExtendedXYZ, detectExtendedXYZ},
+        {InputFormat::StandardXYZ, detectStandardXYZ},
+        {InputFormat::GaussianLog, detectGaussianLog},
+        {InputFormat::GaussianClipboard, detectGaussianClipboard},
+        {InputFormat::SimplifiedXYZ, detectSimplifiedXYZ},
+    };
+    return detectors;
+}
+
+} // namespace
+
+const char* inputFormatName(InputFormat format) {
+    switch (format) {
+        case InputFormat::StandardXYZ: return "standard XYZ";
+        case InputFormat::ExtendedXYZ: return "extended XYZ";
+        case InputFormat::SimplifiedXYZ: return "simplified XYZ";
+        case InputFormat::GaussianClipboard: return "Gaussian clipboard";
+        case InputFormat::GaussianLog: return "Gaussian log";
+        case InputFormat::BinaryTrajectory: return "binary trajectory";
+        default: return "unknown";
+    }
+}
+
+// 注册额外的格式检测器，排在已有检测器之后
+void registerFormatDetector(InputFormat format, FormatDetector detector) {
+    if (!detector) return;
+    std::lock_guard<std::mutex> lock(g_formatDetectorMutex);
+    formatDetectors().push_back({format, detector});
+}
+
+// 嗅探输入格式：耗时只取决于前缀长度，与内容总大小无关
+FormatGuess sniffFormat(std::string_view content) {
+    FormatGuess best;
+    bool truncated = content.size() > FORMAT_SNIFF_BYTES;
+    std::string_view prefix = content.substr(0, FORMAT_SNIFF_BYTES);
+    if (truncated) {
+        size_t lastNewline = prefix.rfind('\n');
+        prefix = lastNewline == std::string_view::npos ? std::string_view() : prefix.substr(0, lastNewline + 1);
+    }
+    if (prefix.empty()) return best;
+    
+    std::lock_guard<std::mutex> lock(g_formatDetectorMutex);
+    for (const FormatDetectorEntry& entry : formatDetectors()) {
+        int confidence = entry.detector(prefix, truncated);
+        if (confidence > best.confidence) {
+            best.format = entry.format;
+            best.confidence = confidence;
+        }
+    }
+    if (best.confidence < FORMAT_MIN_CONFIDENCE) {
+        best = FormatGuess();
+    }
+    LOG_DEBUGF("Sniffed format: %s (confidence %d)", inputFormatName(best.format), best.confidence);
+    return best;
+}
+
+// 写入Gaussian LOG头部
+std::string writeGaussianLogHeader() {
+    return " ! This file was generated by XYZ Monitor\n"
+           " \n"
+           " 0 basis functions\n"
+           " 0 alpha electrons\n"
+           " 0 beta electrons\n"
+           "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
+}
+
+namespace {
+
+// Gaussian LOG几何结构部分，atomicNumbers为按元素ID预先计算的原子序数表
+template <typename Sink>
+void emitGaussianLogGeometry(Sink& sink, const Trajectory& trajectory, size_t frame,
+                             const std::vector<int>& atomicNumbers, int frameNumber) {
+    const std::vector<uint32_t>& elementIds = trajectory.frameElements(frame);
+    size_t begin = trajectory.frameOffsets[frame];
+    size_t count = trajectory.frameAtomCount(frame);
+    
+    sink.literal("GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n");
+    sink.literal(" \n");
+    sink.literal("                         Standard orientation:\n");
+    sink.literal(" ---------------------------------------------------------------------\n");
+    sink.literal(" Center     Atomic      Atomic             Coordinates (Angstroms)\n");
+    sink.literal(" Number     Number       Type             X           Y           Z\n");
+    sink.literal(" ---------------------------------------------------------------------\n");
+    
+    for (size_t i = 0; i < count; ++i) {
+        sink.literal("      ");
+        sink.number(static_cast<long long>(i + 1));
+        sink.literal("          ");
+        sink.number(atomicNumbers[elementIds[i]]);
+        sink.literal("           0        ");
+        sink.fixed6(trajectory.x[begin + i], 10);
+        sink.literal("    ");
+        sink.fixed6(trajectory.y[begin + i], 10);
+        sink.literal("    ");
+        sink.fixed6(trajectory.z[begin + i], 10);
+        sink.literal("\n");
+    }
+    
+    sink.literal(" ---------------------------------------------------------------------\n");
+    sink.literal(" \n");
+    sink.literal(" SCF Done:      -100.000000000\n");
+    sink.literal(" \n");
+    sink.literal("GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n");
+    sink.literal(" Step number   ");
+    sink.number(frameNumber);
+    sink.literal("\n");
+    sink.literal("         Item               Value     Threshold  Converged?\n");
+    sink.literal(" Maximum Force            1.000000     1.000000     NO\n");
+    sink.literal(" RMS     Force            1.000000     1.000000     NO\n");
+    sink.literal(" Maximum Displacement     1.000000     1.000000     NO\n");
+    sink.literal(" RMS     Displacement     1.000000     1.000000     NO\n");
+}
+
+}  // namespace
+
+// Gaussian LOG几何结构部分的精确字节数
+size_t gaussianLogGeometrySize(const Trajectory& trajectory, size_t frame,
+                               const std::vector<int>& atomicNumbers, int frameNumber) {
+    LengthSink sink;
+    emitGaussianLogGeometry(sink, trajectory, frame, atomicNumbers, frameNumber);
+    return sink.length;
+}
+
+// 把Gaussian LOG几何结构部分直接写入out（至少gaussianLogGeometrySize字节），返回写入结束位置
+char* formatGaussianLogGeometry(char* out, const Trajectory& trajectory, size_t frame,
+                                const std::vector<int>& atomicNumbers, int frameNumber) {
+    PointerSink sink{out};
+    emitGaussianLogGeometry(sink, trajectory, frame, atomicNumbers, frameNumber);
+    return sink.out;
+}
+
+// 写入Gaussian LOG几何结构部分
+std::string writeGaussianLogGeometry(const Trajectory& trajectory, size_t frame,
+                                     const std::vector<int>& atomicNumbers, int frameNumber) {
+    std::string out(gaussianLogGeometrySize(trajectory, frame, atomicNumbers, frameNumber), '\0');
+    formatGaussianLogGeometry(&out[0], trajectory, frame, atomicNumbers, frameNumber);
+    return out;
+}
+
+// 写入Gaussian LOG尾部
+std::string writeGaussianLogFooter() {
+    return "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n"
+           " Normal termination of Gaussian\n";
+}
+
+// 按元素ID计算原子序数表（每种符号只查一次）
+std::vector<int> buildAtomicNumberTable(const Trajectory& trajectory) {
+    std::vector<int> atomicNumbers;
+    atomicNumbers.reserve(trajectory.elements.size());
+    for (const std::string& symbol : trajectory.elements) {
+        atomicNumbers.push_back(getAtomicNumber(symbol));
+    }
+    return atomicNumbers;
+}
+
+// 两遍写出多帧几何结构：先并行求出每帧的精确字节数与各帧偏移，再由allocate按总字节数给出目标缓冲区，
+// 各帧并行直接写入其中，没有中间缓冲区。firstFrameNumber为第一帧的步数编号；返回写入的字节数
+size_t formatGaussianLogFrames(const Trajectory& trajectory, int firstFrameNumber, unsigned threads,
+                               const std::function<char*(size_t)>& allocate) {
+    std::vector<int> atomicNumbers = buildAtomicNumberTable(trajectory);
+    const size_t frameCount = trajectory.frameCount();
+    std::vector<size_t> offsets(frameCount + 1, 0);
+    parallelFor(frameCount, threads, 64, [&](size_t i) {
+        offsets[i + 1] = gaussianLogGeometrySize(trajectory, i, atomicNumbers, firstFrameNumber + static_cast<int>(i));
+    });
+    for (size_t i = 0; i < frameCount; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    
+    char* out = allocate(offsets[frameCount]);
+    parallelFor(frameCount, threads, 8, [&](size_t i) {
+        formatGaussianLogGeometry(out + offsets[i], trajectory, i, atomicNumbers, firstFrameNumber + static_cast<int>(i));
+    });
+    return offsets[frameCount];
+}
+
+// 转换为Gaussian LOG格式
+std::string convertToGaussianLog(const Trajectory& trajectory) {
+    if (trajectory.frameCount() == 0) {
+        LOG_ERROR("No frames to convert");
+        return "";
+    }
+    
+    try {
+        const size_t frameCount = trajectory.frameCount();
+        unsigned threads = resolveWorkerThreads(activeConfig().workerThreads);
+        
+        // 头部与尾部长度已知，各帧按精确大小一次分配后直接格式化到输出中
+        const std::string header = writeGaussianLogHeader();
+        const std::string footer = writeGaussianLogFooter();
+        std::string output;
+        size_t framesBytes = formatGaussianLogFrames(trajectory, 1, threads, [&](size_t bytes) {
+            output.resize(header.size() + bytes + footer.size());
+            return &output[header.size()];
+        });
+        std::copy(header.begin(), header.end(), output.begin());
+        std::copy(footer.begin(), footer.end(), output.begin() + header.size() + framesBytes);
+        
+        LOG_DEBUG("Converted " + std::to_string(frameCount) + " frames to Gaussian log format");
+        return output;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in convertToGaussianLog: " + std::string(e.what()));
+        return "";
+    }
+}
+
+// 写缓冲区大小（字节）
+size_t writeBufferBytes() {
+    return static_cast<size_t>(activeConfig().writeBufferKB) * 1024;
+}
+
+bool OutputFileWriter::writeBlock(const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD done = 0;
+        if (!WriteFile(handle, data, chunk, &done, &overlapped) || done == 0) {
+            LOG_ERROR("WriteFile failed for " + path + " (Error: " + std::to_string(GetLastError()) + ")");
+            return false;
+        }
+#else
+        ssize_t done = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (done <= 0) {
+            LOG_ERROR("pwrite failed for " + path + ": " + std::strerror(errno));
+            return false;
+        }
+#endif
+        data += done;
+        size -= static_cast<size_t>(done);
+        offset += static_cast<uint64_t>(done);
+    }
+    return true;
+}
+
+OutputFileWriter::OutputFileWriter(size_t bufferSize) :
+#ifdef _WIN32
+      handle(INVALID_HANDLE_VALUE),
+#else
+      fd(-1),
+#endif
+      buffer(nullptr), capacity(0), used(0), offset(0), preallocated(0) {
+    capacity = std::max(bufferSize, BLOCK_ALIGNMENT);
+    capacity = (capacity + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    // 多分配一个块用于对齐缓冲区起始地址
+    storage.resize(capacity + BLOCK_ALIGNMENT);
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+    buffer = storage.data() + ((BLOCK_ALIGNMENT - address % BLOCK_ALIGNMENT) % BLOCK_ALIGNMENT);
+}
+
+bool OutputFileWriter::isOpen() const {
+#ifdef _WIN32
+    return handle != INVALID_HANDLE_VALUE;
+#else
+    return fd >= 0;
+#endif
+}
+
+bool OutputFileWriter::create(const std::string& filepath, bool& alreadyExists) {
+    alreadyExists = false;
+    path = filepath;
+    used = 0;
+    offset = 0;
+    preallocated = 0;
+#ifdef _WIN32
+    handle = CreateFileA(filepath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_NEW,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        alreadyExists = (GetLastError() == ERROR_FILE_EXISTS);
+        return false;
+    }
+#else
+    fd = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        alreadyExists = (errno == EEXIST);
+        return false;
+    }
+#endif
+    startTime = std::chrono::steady_clock::now();
+    return true;
+}
+
+void OutputFileWriter::preallocate(uint64_t size) {
+    if (!isOpen() || size == 0) return;
+#ifdef _WIN32
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    if (SetFilePointerEx(handle, position, NULL, FILE_BEGIN) && SetEndOfFile(handle)) {
+        preallocated = size;
+    } else {
+        LOG_DEBUG("Preallocation failed for " + path + " (Error: " + std::to_string(GetLastError()) + ")");
+    }
+#else
+    int result = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+    if (result == 0) {
+        preallocated = size;
+    } else {
+        LOG_DEBUG("Preallocation failed for " + path + ": " + std::strerror(result));
+    }
+#endif
+}
+
+bool OutputFileWriter::write(const char* data, size_t size) {
+    if (!isOpen()) return false;
+    
+    // 先填满当前块
+    if (used > 0) {
+        size_t room = capacity - used;
+        size_t take = std::min(room, size);
+        std::memcpy(buffer + used, data, take);
+        used += take;
+        data += take;
+        size -= take;
+        if (used < capacity) return true;
+        if (!writeBlock(buffer, capacity)) return false;
+        used = 0;
+    }
+    
+    // 整块数据直接写出，不经过缓冲区
+    size_t direct = size / capacity * capacity;
+    if (direct > 0) {
+        if (!writeBlock(data, direct)) return false;
+        data += direct;
+        size -= direct;
+    }
+    
+    std::memcpy(buffer, data, size);
+    used = size;
+    return true;
+}
+
+bool OutputFileWriter::finish(bool report) {
+    if (!isOpen()) return true;
+    
+    bool ok = used == 0 || writeBlock(buffer, used);
+    used = 0;
+#ifdef _WIN32
+    if (ok && preallocated > offset) {
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(offset);
+        ok = SetFilePointerEx(handle, position, NULL, FILE_BEGIN) && SetEndOfFile(handle);
+    }
+    CloseHandle(handle);
+    handle = INVALID_HANDLE_VALUE;
+#else
+    if (ok && preallocated > offset) {
+        ok = ::ftruncate(fd, static_cast<off_t>(offset)) == 0;
+    }
+    ok = (::close(fd) == 0) && ok;
+    fd = -1;
+#endif
+    
+    if (!ok) {
+        LOG_ERROR("Failed to finish writing " + path);
+    } else if (report && g_logger.isEnabled(LogLevel::INFO)) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        double megabytes = static_cast<double>(offset) / (1024.0 * 1024.0);
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1) << "Wrote " << megabytes << "MB to " << path << " in "
+            << (seconds * 1000.0) << "ms (" << (seconds > 0 ? megabytes / seconds : 0.0) << " MB/s)";
+        LOG_INFO(oss.str());
+    }
+    return ok;
+}
+
+// 在临时目录中独占创建不重名的临时文件：文件名包含时间戳、进程ID和序号，
+// 已存在时递增序号重试。返回文件路径，失败时返回空字符串
+std::string createUniqueTempFile(OutputFileWriter& writer) {
+    if (!activeConfig().tempDir.empty()) {
+        std::filesystem::create_directories(activeConfig().tempDir);
+    }
+    
+    static std::atomic<unsigned> sequence(0);
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(::getpid());
+#endif
+    long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        std::ostringstream filename;
+        filename << "molecule_" << millis << "_" << pid << "_" << sequence.fetch_add(1) << ".log";
+        std::string filepath = activeConfig().tempDir.empty() ? filename.str() : activeConfig().tempDir + "/" + filename.str();
+        
+        bool alreadyExists;
+        if (writer.create(filepath, alreadyExists)) {
+            return filepath;
+        }
+        if (!alreadyExists) {
+            LOG_ERROR("Failed to create temp file: " + filepath);
+            return "";
+        }
+    }
+    
+    LOG_ERROR("Failed to find an unused temp file name in: " + activeConfig().tempDir);
+    return "";
+}
+
+// 创建临时文件
+std::string createTempFile(const std::string& content) {
+    try {
+        OutputFileWriter writer(writeBufferBytes());
+        std::string filepath = createUniqueTempFile(writer);
+        if (filepath.empty()) {
+            return "";
+        }
+        
+        writer.preallocate(content.size());
+        if (!writer.write(content) || !writer.close()) {
+            LOG_ERROR("Failed to write temp file: " + filepath);
+            std::error_code ec;
+            std::filesystem::remove(filepath, ec);
+            return "";
+        }
+        
+        LOG_INFO("Created temporary file: " + filepath);
+        return filepath;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception creating temp file: " + std::string(e.what()));
+        return "";
+    }
+}
+
+// 全局临时文件回收器
+TempFileReaper g_reaper;
+
+TempFileReaper::Task TempFileReaper::pop() {
+    std::pop_heap(tasks.begin(), tasks.end(), LaterDue());
+    Task task = std::move(tasks.back());
+    tasks.pop_back();
+    return task;
+}
+
+bool TempFileReaper::removeFile(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    if (!ec) {
+        LOG_DEBUG("Deleted temporary file: " + path);
+        return true;
+    }
+    if (!std::filesystem::exists(path)) {
+        return true;
+    }
+    LOG_DEBUG("Failed to delete temporary file: " + path + " (" + ec.message() + ")");
+    return false;
+}
+
+bool TempFileReaper::process(Task& task) {
+    Clock::time_point now = Clock::now();
+    if (task.ready) {
+        if (now < task.readyDeadline && !task.ready()) {
+            task.due = now + std::chrono::milliseconds(READY_POLL_MS);
+            return true;
+        }
+        // 已就绪（或不再等待）：留出宽限时间让查看器读完文件
+        task.ready = nullptr;
+        task.due = now + std::chrono::milliseconds(READY_GRACE_MS);
+        return true;
+    }
+    
+    if (removeFile(task.path)) {
+        return false;
+    }
+    if (++task.attempt >= MAX_ATTEMPTS) {
+        LOG_WARNING("Giving up deleting temporary file after " + std::to_string(task.attempt) +
+                    " attempts: " + task.path);
+        return false;
+    }
+    task.due = now + std::chrono::seconds(1 << (task.attempt - 1));
+    return true;
+}
+
+void TempFileReaper::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (tasks.empty()) {
+            wakeup.wait(lock);
+            continue;
+        }
+        if (Clock::now() < tasks.front().due) {
+            wakeup.wait_until(lock, tasks.front().due);
+            continue;
+        }
+        
+        Task task = pop();
+        lock.unlock();
+        bool again = false;
+        try {
+            again = process(task);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception in temp file reaper: " + std::string(e.what()));
+        }
+        lock.lock();
+        if (again) {
+            push(std::move(task));
+        }
+    }
+}
+
+void TempFileReaper::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (worker.joinable()) return;
+    stopping = false;
+    worker = std::thread(&TempFileReaper::run, this);
+}
+
+void TempFileReaper::schedule(const std::string& path, std::chrono::milliseconds delay, ReadyCheck ready) {
+    Clock::time_point now = Clock::now();
+    Task task;
+    task.path = path;
+    task.attempt = 0;
+    task.readyDeadline = now + delay;
+    task.due = ready ? now : now + delay;
+    task.ready = std::move(ready);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        push(std::move(task));
+    }
+    wakeup.notify_one();
+}
+
+size_t TempFileReaper::sweepStale(const std::string& directory, std::chrono::seconds maxAge) {
+    std::error_code ec;
+    std::filesystem::path dir = directory.empty() ? std::filesystem::path(".") : std::filesystem::path(directory);
+    if (!std::filesystem::is_directory(dir, ec)) return 0;
+    
+    auto cutoff = std::filesystem::file_time_type::clock::now() - maxAge;
+    size_t removed = 0;
+    for (const auto& item : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = item.path().filename().string();
+        if (name.compare(0, 9, "molecule_") != 0 || item.path().extension() != ".log") continue;
+        
+        std::error_code itemEc;
+        if (item.last_write_time(itemEc) > cutoff || itemEc) continue;
+        if (std::filesystem::remove(item.path(), itemEc)) {
+            ++removed;
+        } else {
+            LOG_WARNING("Failed to remove stale temporary file: " + item.path().string());
+        }
+    }
+    if (removed > 0) {
+        LOG_INFO("Removed " + std::to_string(removed) + " stale temporary file(s) from " + dir.string());
+    }
+    return removed;
+}
+
+void TempFileReaper::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    
+    std::vector<Task> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining.swap(tasks);
+    }
+    for (int attempt = 1; !remaining.empty(); ++attempt) {
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [](const Task& task) { return removeFile(task.path); }),
+                        remaining.end());
+        if (remaining.empty() || attempt >= STOP_ATTEMPTS) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(STOP_RETRY_MS));
+    }
+    for (const Task& task : remaining) {
+        LOG_WARNING("Temporary file still in use at exit, left for the next start: " + task.path);
+    }
+}
+
+// 全局转换结果缓存
+ConversionCache g_conversionCache;
+
+void ConversionCache::loadExisting() {
+    loaded = true;
+    std::error_code ec;
+    std::filesystem::path dir = activeConfig().tempDir.empty() ? std::filesystem::path(".") : std::filesystem::path(activeConfig().tempDir);
+    if (!std::filesystem::is_directory(dir, ec)) return;
+    
+    std::vector<std::pair<std::filesystem::file_time_type, Entry>> found;
+    for (const auto& item : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = item.path().filename().string();
+        unsigned long long key = 0;
+        std::string extension = name.size() > 25 ? name.substr(25) : std::string();
+        if (name.compare(0, 9, "xyzcache_") != 0 || (extension != ".log" && extension != ".xyzb")) continue;
+        if (std::from_chars(name.data() + 9, name.data() + 25, key, 16).ptr != name.data() + 25) continue;
+        
+        std::error_code itemEc;
+        uintmax_t bytes = item.file_size(itemEc);
+        auto modified = item.last_write_time(itemEc);
+        if (itemEc) continue;
+        found.push_back({modified, Entry{key, cachePath(key, extension.c_str()), bytes}});
+    }
+    
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (auto& item : found) {
+        entries.push_back(item.second);
+        index[item.second.key] = std::prev(entries.end());
+        totalBytes += item.second.bytes;
+    }
+    if (!found.empty()) {
+        LOG_DEBUG("Restored " + std::to_string(found.size()) + " cached conversion(s) from " + dir.string());
+    }
+    evict();
+}
+
+void ConversionCache::evict() {
+    const uintmax_t maxBytes = static_cast<uintmax_t>(activeConfig().cacheMaxMB) * 1024 * 1024;
+    const size_t maxEntries = static_cast<size_t>(activeConfig().cacheMaxEntries);
+    while (!entries.empty() && (entries.size() > maxEntries || totalBytes > maxBytes)) {
+        Entry& victim = entries.back();
+        std::error_code ec;
+        std::filesystem::remove(victim.path, ec);
+        if (ec) {
+            // 文件可能仍被查看器占用，交给回收线程重试
+            LOG_DEBUG("Evicted cache file is busy, deferring deletion: " + victim.path);
+            g_reaper.schedule(victim.path, std::chrono::seconds(1));
+        } else {
+            LOG_DEBUG("Evicted cached conversion: " + victim.path);
+        }
+        totalBytes -= victim.bytes;
+        index.erase(victim.key);
+        entries.pop_back();
+    }
+}
+
+std::string ConversionCache::lookup(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) loadExisting();
+    
+    auto it = index.find(key);
+    if (it != index.end()) {
+        std::error_code ec;
+        if (std::filesystem::exists(it->second->path, ec)) {
+            entries.splice(entries.begin(), entries, it->second);
+            ++hits;
+            LOG_INFO("Conversion cache hit: " + it->second->path + " (" + rateText() + ")");
+            return it->second->path;
+        }
+        // 文件已被外部删除
+        totalBytes -= it->second->bytes;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    
+    ++misses;
+    LOG_INFO("Conversion cache miss (" + rateText() + ")");
+    return "";
+}
+
+std::string ConversionCache::insert(uint64_t key, const std::string& file, const char* extension) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) loadExisting();
+    
+    std::string path = cachePath(key, extension);
+    std::error_code ec;
+    uintmax_t bytes = std::filesystem::file_size(file, ec);
+    if (ec || bytes > static_cast<uintmax_t>(activeConfig().cacheMaxMB) * 1024 * 1024) {
+        return "";
+    }
+    
+    auto it = index.find(key);
+    if (it != index.end()) {
+        totalBytes -= it->second->bytes;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    
+    std::filesystem::rename(file, path, ec);
+    if (ec) {
+        LOG_WARNING("Failed to move " + file + " into the conversion cache: " + ec.message());
+        return "";
+    }
+    
+    entries.push_front(Entry{key, path, bytes});
+    index[key] = entries.begin();
+    totalBytes += bytes;
+    LOG_DEBUG("Cached conversion as " + path + " (" + std::to_string(entries.size()) + " entries, " +
+              std::to_string(totalBytes / (1024 * 1024)) + "MB)");
+    evict();
+    return path;
+}
+
+// 缓存版本：输出格式改变时递增，使旧的缓存文件不再命中
+const char* const CONVERSION_CACHE_VERSION = "gaussian-log-1";
+
+// 计算转换缓存键：剪贴板内容的哈希，再混入帧选择（自动步长还取决于内存上限）
+uint64_t conversionCacheKey(std::string_view content, const FrameSelection& selection) {
+    std::string variant = std::string(CONVERSION_CACHE_VERSION) + "|" + selection.describe();
+    if (selection.autoStride) {
+        variant += "|" + std::to_string(activeConfig().maxMemoryMB);
+    }
+    return xxh64(variant.data(), variant.size(), xxh64(content.data(), content.size()));
+}
+
+// 检查数据是否以.xyzb魔数开头
+bool isBinaryTrajectory(std::string_view data) {
+    return data.size() >= sizeof(BINARY_TRAJECTORY_MAGIC) &&
+           std::memcmp(data.data(), BINARY_TRAJECTORY_MAGIC, sizeof(BINARY_TRAJECTORY_MAGIC)) == 0;
+}
+
+bool BinaryTrajectoryWriter::writeRaw(const void* data, size_t size) {
+    if (!failed && !file.write(static_cast<const char*>(data), size)) {
+        failed = true;
+    }
+    return !failed;
+}
+
+uint32_t BinaryTrajectoryWriter::mapElement(const std::string& symbol) {
+    auto it = elementIds.find(symbol);
+    if (it != elementIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(elements.size());
+    elements.push_back(symbol);
+    elementIds.emplace(symbol, id);
+    return id;
+}
+
+template <typename Float>
+    bool BinaryTrajectoryWriter::writeCoordinates(const Trajectory& batch, size_t begin, size_t end) {
+    scratch.resize((end - begin) * 3 * sizeof(Float));
+    Float* out = reinterpret_cast<Float*>(scratch.data());
+    for (size_t i = begin; i < end; ++i) {
+        *out++ = static_cast<Float>(batch.x[i]);
+        *out++ = static_cast<Float>(batch.y[i]);
+        *out++ = static_cast<Float>(batch.z[i]);
+    }
+    return writeRaw(scratch.data(), scratch.size());
+}
+
+bool BinaryTrajectoryWriter::create() {
+    path = createUniqueTempFile(file);
+    if (path.empty()) {
+        return false;
+    }
+    BinaryTrajectoryHeader header = {};
+    std::memcpy(header.magic, BINARY_TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_TRAJECTORY_VERSION;
+    header.flags = doublePrecision ? BINARY_TRAJECTORY_FLOAT64 : 0;
+    return writeValue(header);
+}
+
+bool BinaryTrajectoryWriter::append(const Trajectory& batch) {
+    if (!ok()) return false;
+    
+    std::vector<uint32_t> remap(batch.elements.size(), Trajectory::UNKNOWN_ELEMENT);
+    std::vector<uint32_t> topology;
+    for (size_t frame = 0; frame < batch.frameCount(); ++frame) {
+        const std::vector<uint32_t>& ids = batch.frameElements(frame);
+        topology.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (remap[ids[i]] == Trajectory::UNKNOWN_ELEMENT) {
+                remap[ids[i]] = mapElement(batch.elements[ids[i]]);
+            }
+            topology[i] = remap[ids[i]];
+        }
+        if (topologies.empty() || topologies.back() != topology) {
+            topologies.push_back(topology);
+        }
+        frameTopology.push_back(static_cast<uint32_t>(topologies.size() - 1));
+        
+        size_t begin = batch.frameOffsets[frame];
+        size_t end = batch.frameOffsets[frame + 1];
+        bool written = doublePrecision ? writeCoordinates<double>(batch, begin, end)
+                                       : writeCoordinates<float>(batch, begin, end);
+        if (!written) return false;
+        frameOffsets.push_back(frameOffsets.back() + (end - begin));
+        
+        comments += batch.comments[frame];
+        commentOffsets.push_back(comments.size());
+    }
+    return true;
+}
+
+bool BinaryTrajectoryWriter::finish() {
+    if (!ok() || frameTopology.empty()) {
+        discard();
+        return false;
+    }
+    
+    BinaryTrajectoryTrailer trailer = {};
+    trailer.frameCount = frameTopology.size();
+    trailer.totalAtoms = frameOffsets.back();
+    trailer.elementCount = elements.size();
+    trailer.topologyCount = topologies.size();
+    
+    pad();
+    trailer.elementsOffset = file.bytesWritten();
+    for (const std::string& symbol : elements) {
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(symbol.size(), 0xFFFF));
+        writeValue(length);
+        writeRaw(symbol.data(), length);
+    }
+    
+    pad();
+    trailer.topologiesOffset = file.bytesWritten();
+    for (const std::vector<uint32_t>& topology : topologies) {
+        writeValue(static_cast<uint64_t>(topology.size()));
+        writeRaw(topology.data(), topology.size() * sizeof(uint32_t));
+        pad();
+    }
+    
+    trailer.frameTopologyOffset = file.bytesWritten();
+    writeRaw(frameTopology.data(), frameTopology.size() * sizeof(uint32_t));
+    pad();
+    trailer.frameOffsetsOffset = file.bytesWritten();
+    writeRaw(frameOffsets.data(), frameOffsets.size() * sizeof(uint64_t));
+    trailer.commentOffsetsOffset = file.bytesWritten();
+    writeRaw(commentOffsets.data(), commentOffsets.size() * sizeof(uint64_t));
+    trailer.commentsOffset = file.bytesWritten();
+    writeRaw(comments.data(), comments.size());
+    pad();
+    
+    std::memcpy(trailer.magic, BINARY_TRAJECTORY_END_MAGIC, sizeof(trailer.magic));
+    writeValue(trailer);
+    
+    bool closed = !failed && file.close();
+    if (!closed) {
+        discard();
+        return false;
+    }
+    finished = true;
+    return true;
+}
+
+void BinaryTrajectoryWriter::discard() {
+    if (path.empty() || finished) return;
+    file.abandon();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    path.clear();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to open " + path + " (Error: " + std::to_string(GetLastError()) + ")");
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        LOG_ERROR("Cannot map empty or unreadable file: " + path);
+        close();
+        return false;
+    }
+    if (static_cast<uint64_t>(size.QuadPart) > SIZE_MAX) {
+        LOG_ERROR("File is too large to map in this process (" + std::to_string(size.QuadPart) + " bytes): " + path);
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        LOG_ERROR("CreateFileMapping failed for " + path + " (Error: " + std::to_string(GetLastError()) + ")");
+        close();
+        return false;
+    }
+    view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr) {
+        LOG_ERROR("MapViewOfFile failed for " + path + " (Error: " + std::to_string(GetLastError()) + ")");
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(size.QuadPart);
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        LOG_ERROR("Cannot map empty or unreadable file: " + path);
+        close();
+        return false;
+    }
+    if (static_cast<uint64_t>(info.st_size) > SIZE_MAX) {
+        LOG_ERROR("File is too large to map in this process (" + std::to_string(info.st_size) + " bytes): " + path);
+        close();
+        return false;
+    }
+    void* address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        LOG_ERROR("mmap failed for " + path + ": " + std::strerror(errno));
+        close();
+        return false;
+    }
+    view = static_cast<const char*>(address);
+    length = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (view) ::munmap(const_cast<char*>(view), length);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+#endif
+    view = nullptr;
+    length = 0;
+}
+
+bool BinaryTrajectoryReader::open(const std::string& path) {
+    elements.clear();
+    topologyOffsets.clear();
+    if (!mapped.open(path)) {
+        return false;
+    }
+    
+    const uint64_t size = mapped.size();
+    if (size < sizeof(BinaryTrajectoryHeader) + sizeof(BinaryTrajectoryTrailer) ||
+        !isBinaryTrajectory(std::string_view(mapped.data(), mapped.size()))) {
+        return fail(path, "missing header");
+    }
+    BinaryTrajectoryHeader header = at<BinaryTrajectoryHeader>(0);
+    if (header.version != BINARY_TRAJECTORY_VERSION || (header.flags & ~BINARY_TRAJECTORY_FLOAT64) != 0) {
+        return fail(path, "unsupported version " + std::to_string(header.version));
+    }
+    coordinateBytes = (header.flags & BINARY_TRAJECTORY_FLOAT64) ? 8 : 4;
+    
+    const uint64_t tableEnd = size - sizeof(BinaryTrajectoryTrailer);
+    trailer = at<BinaryTrajectoryTrailer>(tableEnd);
+    if (std::memcmp(trailer.magic, BINARY_TRAJECTORY_END_MAGIC, sizeof(trailer.magic)) != 0) {
+        return fail(path, "missing trailer (file is truncated)");
+    }
+    
+    // 各段依次排列且不越界；数量先按文件大小设上限，避免乘法溢出
+    const uint64_t sections[] = {sizeof(BinaryTrajectoryHeader), trailer.elementsOffset, trailer.topologiesOffset,
+                                 trailer.frameTopologyOffset, trailer.frameOffsetsOffset,
+                                 trailer.commentOffsetsOffset, trailer.commentsOffset, tableEnd};
+    for (size_t i = 1; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+        if (sections[i] < sections[i - 1]) return fail(path, "section offsets out of order");
+    }
+    if (trailer.frameCount == 0 || trailer.frameCount > size / 8 || trailer.totalAtoms > size / 12 ||
+        trailer.elementCount > size || trailer.topologyCount > size / 8) {
+        return fail(path, "table sizes exceed the file");
+    }
+    if (sizeof(BinaryTrajectoryHeader) + trailer.totalAtoms * 3 * coordinateBytes > trailer.elementsOffset ||
+        trailer.frameTopologyOffset + trailer.frameCount * sizeof(uint32_t) > trailer.frameOffsetsOffset ||
+        trailer.frameOffsetsOffset + (trailer.frameCount + 1) * sizeof(uint64_t) > trailer.commentOffsetsOffset ||
+        trailer.commentOffsetsOffset + (trailer.frameCount + 1) * sizeof(uint64_t) > trailer.commentsOffset) {
+        return fail(path, "tables overlap");
+    }
+    
+    uint64_t cursor = trailer.elementsOffset;
+    for (uint64_t i = 0; i < trailer.elementCount; ++i) {
+        if (cursor + sizeof(uint16_t) > trailer.topologiesOffset) return fail(path, "element table is truncated");
+        uint16_t length = at<uint16_t>(cursor);
+        cursor += sizeof(uint16_t);
+        if (cursor + length > trailer.topologiesOffset) return fail(path, "element table is truncated");
+        elements.emplace_back(mapped.data() + cursor, length);
+        cursor += length;
+    }
+    
+    cursor = trailer.topologiesOffset;
+    for (uint64_t i = 0; i < trailer.topologyCount; ++i) {
+        if (cursor + sizeof(uint64_t) > trailer.frameTopologyOffset) return fail(path, "topology table is truncated");
+        uint64_t count = at<uint64_t>(cursor);
+        cursor += sizeof(uint64_t);
+        if (count > (trailer.frameTopologyOffset - cursor) / sizeof(uint32_t)) {
+            return fail(path, "topology table is truncated");
+        }
+        topologyOffsets.push_back(cursor);
+        for (uint64_t k = 0; k < count; ++k) {
+            if (at<uint32_t>(cursor + k * sizeof(uint32_t)) >= trailer.elementCount) {
+                return fail(path, "topology refers to an unknown element");
+            }
+        }
+        cursor += (count * sizeof(uint32_t) + 7) / 8 * 8;
+    }
+    
+    const uint64_t commentBytes = tableEnd - trailer.commentsOffset;
+    if (frameOffset(0) != 0 || commentOffset(0) != 0) return fail(path, "frame table does not start at zero");
+    for (size_t frame = 0; frame < trailer.frameCount; ++frame) {
+        uint32_t topology = frameTopology(frame);
+        if (topology >= trailer.topologyCount) return fail(path, "frame refers to an unknown topology");
+        uint64_t begin = frameOffset(frame);
+        uint64_t end = frameOffset(frame + 1);
+        if (end < begin || end > trailer.totalAtoms ||
+            end - begin != at<uint64_t>(topologyOffsets[topology] - sizeof(uint64_t))) {
+            return fail(path, "frame atom counts do not match the topology");
+        }
+        if (commentOffset(frame + 1) < commentOffset(frame) || commentOffset(frame + 1) > commentBytes) {
+            return fail(path, "comment table is out of range");
+        }
+    }
+    if (frameOffset(trailer.frameCount) != trailer.totalAtoms) return fail(path, "atom count mismatch");
+    return true;
+}
+
+void BinaryTrajectoryReader::readFrames(const size_t* frames, size_t count, Trajectory& trajectory) const {
+    std::vector<uint32_t> remap(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) {
+        remap[i] = trajectory.addElement(elements[i]);
+    }
+    
+    size_t atoms = 0;
+    for (size_t k = 0; k < count; ++k) {
+        atoms += frameAtomCount(frames[k]);
+    }
+    trajectory.reserveAtoms(trajectory.totalAtoms() + atoms);
+    
+    for (size_t k = 0; k < count; ++k) {
+        const size_t frame = frames[k];
+        const uint64_t begin = frameOffset(frame);
+        const uint64_t end = frameOffset(frame + 1);
+        const uint64_t commentBegin = trailer.commentsOffset + commentOffset(frame);
+        trajectory.beginFrame(std::string_view(mapped.data() + commentBegin,
+                                               commentOffset(frame + 1) - commentOffset(frame)));
+        
+        const uint64_t topology = topologyOffsets[frameTopology(frame)];
+        const char* coordinates = mapped.data() + sizeof(BinaryTrajectoryHeader) + begin * 3 * coordinateBytes;
+        for (uint64_t i = 0; i < end - begin; ++i) {
+            double xyz[3];
+            if (coordinateBytes == 8) {
+                std::memcpy(xyz, coordinates + i * 24, sizeof(xyz));
+            } else {
+                float values[3];
+                std::memcpy(values, coordinates + i * 12, sizeof(values));
+                xyz[0] = values[0];
+                xyz[1] = values[1];
+                xyz[2] = values[2];
+            }
+            trajectory.pending.push_back(remap[at<uint32_t>(topology + i * sizeof(uint32_t))]);
+            trajectory.x.push_back(xyz[0]);
+            trajectory.y.push_back(xyz[1]);
+            trajectory.z.push_back(xyz[2]);
+        }
+        trajectory.endFrame();
+    }
+}
+
+// 流式转换（标准XYZ格式）：按工作集预算分批扫描帧边界、并行解析和格式化，
+// 写入已创建的文件后释放该批数据，内存占用与轨迹长度无关。单帧超过预算时失败。
+// selected非空时只转换这些已选出的帧，不再扫描；capture非空时同时把每批帧追加到二进制轨迹
+bool streamXYZToGaussianLog(std::string_view content, OutputFileWriter& writer,
+                            size_t budgetBytes, StreamStats& stats, ConversionProgress* progress,
+                            const std::vector<FrameSpan>* selected,
+                            BinaryTrajectoryWriter* capture) {
+    try {
+        size_t bufferSize = writeBufferBytes();
+        if (budgetBytes <= bufferSize + STREAM_BYTES_PER_ATOM) {
+            LOG_ERROR("Memory budget is too small for streaming conversion");
+            return false;
+        }
+        const size_t maxBatchAtoms = (budgetBytes - bufferSize) / STREAM_BYTES_PER_ATOM;
+        unsigned threads = resolveWorkerThreads(activeConfig().workerThreads);
+        
+        if (!writer.write(writeGaussianLogHeader())) {
+            LOG_ERROR("Failed to write Gaussian log header");
+            writer.abandon();
+            return false;
+        }
+        
+        LineCursor cursor(content);
+        size_t nextSelected = 0;
+        Trajectory batch;
+        std::string batchText;  // 每批的输出文本，按精确大小格式化，批之间复用
+        bool finished = false;
+        while (!finished) {
+            if (isCancelled(progress)) {
+                LOG_INFO("Streaming conversion cancelled after " + std::to_string(stats.frames) + " frames");
+                return false;
+            }
+            std::vector<FrameSpan> spans;
+            if (selected) {
+                spans = takeFrameSpans(*selected, nextSelected, maxBatchAtoms);
+                finished = nextSelected >= selected->size();
+            } else {
+                TraceSpan scanSpan("frame_scan");
+                spans = scanXYZFrameSpans(cursor, maxBatchAtoms, finished);
+            }
+            if (spans.empty()) break;
+            
+            if (spans.size() == 1 && spans[0].atomLines > maxBatchAtoms) {
+                LOG_ERROR("Frame at line " + std::to_string(spans[0].countLine) + " has " +
+                          std::to_string(spans[0].atomLines) + " atoms, which exceeds the " +
+                          std::to_string(activeConfig().maxMemoryMB) + "MB memory budget");
+                writer.abandon();
+                return false;
+            }
+            
+            batch.clearFrames();
+            TraceSpan parseSpan("parse");
+            parseXYZFramesParallel(content, spans, batch, threads, progress);
+            parseSpan.end();
+            if (memoryBudgetExceeded()) {
+                writer.abandon();
+                return false;
+            }
+            if (isCancelled(progress)) continue;
+            if (batch.frameCount() < spans.size()) {
+                finished = true;  // 某帧无法读取，与串行读取一样在此停止
+            }
+            if (capture) {
+                TraceSpan captureSpan("binary_capture");
+                capture->append(batch);
+            }
+            
+            TraceSpan convertSpan("convert");
+            size_t textBytes = formatGaussianLogFrames(batch, static_cast<int>(stats.frames + 1), threads,
+                                                       [&](size_t bytes) {
+                                                           batchText.resize(bytes);
+                                                           return &batchText[0];
+                                                       });
+            convertSpan.end();
+            size_t batchBytes = batch.memoryBytes() + bufferSize + batchText.capacity();
+            stats.peakWorkingSet = std::max(stats.peakWorkingSet, batchBytes);
+            
+            TraceSpan writeSpan("temp_file_write");
+            if (!writer.write(batchText.data(), textBytes)) {
+                LOG_ERROR("Failed to write converted frames");
+                writer.abandon();
+                return false;
+            }
+            writeSpan.end();
+            
+            stats.frames += batch.frameCount();
+            stats.atoms += batch.totalAtoms();
+            if (progress) progress->framesWritten.store(stats.frames, std::memory_order_relaxed);
+            LOG_DEBUG("Streamed batch of " + std::to_string(batch.frameCount()) + " frames (" +
+                      std::to_string(stats.frames) + " total)");
+        }
+        
+        TraceSpan closeSpan("temp_file_write");
+        if (!writer.write(writeGaussianLogFooter())) {
+            LOG_ERROR("Failed to write Gaussian log footer");
+            writer.abandon();
+            return false;
+        }
+        stats.bytesWritten = writer.bytesWritten();
+        if (!writer.close()) {
+            return false;
+        }
+        return stats.frames > 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in streamXYZToGaussianLog: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 把二进制轨迹中选出的帧流式转换为Gaussian log：按工作集预算分批从映射的文件读入并格式化
+bool streamBinaryTrajectoryToGaussianLog(const BinaryTrajectoryReader& reader, const std::vector<size_t>& frames,
+                                         OutputFileWriter& writer, size_t budgetBytes, StreamStats& stats,
+                                         ConversionProgress* progress) {
+    try {
+        size_t bufferSize = writeBufferBytes();
+        if (budgetBytes <= bufferSize + STREAM_BYTES_PER_ATOM) {
+            LOG_ERROR("Memory budget is too small for streaming conversion");
+            return false;
+        }
+        const size_t maxBatchAtoms = (budgetBytes - bufferSize) / STREAM_BYTES_PER_ATOM;
+        unsigned threads = resolveWorkerThreads(activeConfig().workerThreads);
+        
+        if (!writer.write(writeGaussianLogHeader())) {
+            LOG_ERROR("Failed to write Gaussian log header");
+            writer.abandon();
+            return false;
+        }
+        
+        Trajectory batch;
+        std::string batchText;  // 每批的输出文本，按精确大小格式化，批之间复用
+        size_t next = 0;
+        while (next < frames.size()) {
+            if (isCancelled(progress)) {
+                LOG_INFO("Binary trajectory conversion cancelled after " + std::to_string(stats.frames) + " frames");
+                return false;
+            }
+            
+            size_t first = next;
+            size_t batchAtoms = 0;
+            while (next < frames.size() && (next == first || batchAtoms < maxBatchAtoms)) {
+                batchAtoms += reader.frameAtomCount(frames[next++]);
+            }
+            if (next - first == 1 && batchAtoms > maxBatchAtoms) {
+                LOG_ERROR("Frame " + std::to_string(frames[first]) + " has " + std::to_string(batchAtoms) +
+                          " atoms, which exceeds the " + std::to_string(activeConfig().maxMemoryMB) + "MB memory budget");
+                writer.abandon();
+                return false;
+            }
+            
+            batch.clearFrames();
+            TraceSpan readSpan("binary_read");
+            reader.readFrames(frames.data() + first, next - first, batch);
+            readSpan.end();
+            if (progress) progress->framesParsed.store(next, std::memory_order_relaxed);
+            
+            TraceSpan convertSpan("convert");
+            size_t textBytes = formatGaussianLogFrames(batch, static_cast<int>(stats.frames + 1), threads,
+                                                       [&](size_t bytes) {
+                                                           batchText.resize(bytes);
+                                                           return &batchText[0];
+                                                       });
+            convertSpan.end();
+            size_t batchBytes = batch.memoryBytes() + bufferSize + batchText.capacity();
+            stats.peakWorkingSet = std::max(stats.peakWorkingSet, batchBytes);
+            
+            TraceSpan writeSpan("temp_file_write");
+            if (!writer.write(batchText.data(), textBytes)) {
+                LOG_ERROR("Failed to write converted frames");
+                writer.abandon();
+                return false;
+            }
+            writeSpan.end();
+            
+            stats.frames += batch.frameCount();
+            stats.atoms += batch.totalAtoms();
+            if (progress) progress->framesWritten.store(stats.frames, std::memory_order_relaxed);
+        }
+        
+        TraceSpan closeSpan("temp_file_write");
+        if (!writer.write(writeGaussianLogFooter())) {
+            LOG_ERROR("Failed to write Gaussian log footer");
+            writer.abandon();
+            return false;
+        }
+        stats.bytesWritten = writer.bytesWritten();
+        if (!writer.close()) {
+            return false;
+        }
+        return stats.frames > 0;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in streamBinaryTrajectoryToGaussianLog: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 第一行是原子数（标准格式，可以流式转换）
+static bool startsWithAtomCount(std::string_view content) {
+    int firstCount;
+    LineCursor firstLineCursor(content);
+    std::string_view firstLine;
+    return firstLineCursor.next(firstLine) && parseInt(firstLine, firstCount);
+}
+
+// 把XYZ文本转换为Gaussian log，写入已创建的writer（成功时已关闭）。标准格式且启用stream_conversion时
+// 按批流式转换，否则整体解析后写出；多帧标准XYZ只转换selection选中的帧。
+// capture非空时把转换的帧追加到二进制轨迹（有帧选择时不追加）。整体转换在解析完成后调用inputParsed。
+// 失败原因已记录日志，调用方负责删除文件
+bool convertXYZToGaussianLog(std::string_view content, OutputFileWriter& writer, const FrameSelection& selection,
+                             StreamStats& stats, ConversionProgress* progress, BinaryTrajectoryWriter* capture,
+                             const std::function<void()>& inputParsed) {
+    bool standardFormat = startsWithAtomCount(content);
+    
+    // 帧选择：先扫描全部帧边界（不切分坐标字段），只保留选中帧的索引
+    bool useSelection = standardFormat && selection.active();
+    std::vector<FrameSpan> selected;
+    if (useSelection) {
+        TraceSpan checkSpan("format_check");
+        if (!isXYZFormat(content)) {
+            LOG_INFO("Invalid XYZ format.");
+            return false;
+        }
+        checkSpan.end();
+        
+        TraceSpan scanSpan("frame_scan");
+        LineCursor cursor(content);
+        bool finished;
+        std::vector<FrameSpan> spans = scanXYZFrameSpans(cursor, 0, finished);
+        size_t budgetAtoms = availableConversionMemory() / STREAM_BYTES_PER_ATOM;
+        size_t stride;
+        selected = selectFrameSpans(spans, selection, budgetAtoms, stride);
+        scanSpan.end();
+        LOG_INFO("Selected " + std::to_string(selected.size()) + " of " + std::to_string(spans.size()) +
+                 " frames (" + selection.describe() +
+                 (selection.autoStride ? ", stride " + std::to_string(stride) : std::string()) + ")");
+        if (selected.empty()) {
+            LOG_WARNING("Frame selection matched no frames.");
+            return false;
+        }
+        capture = nullptr;
+    }
+    
+    // 流式转换：标准格式按批解析并直接写入文件
+    if (activeConfig().streamConversion && standardFormat) {
+        TraceSpan checkSpan("format_check");
+        if (!useSelection && !isXYZFormat(content)) {
+            LOG_INFO("Invalid XYZ format.");
+            return false;
+        }
+        checkSpan.end();
+        
+        size_t budgetBytes = availableConversionMemory();
+        LOG_INFO("Streaming " + std::to_string(content.length()) + " characters (working-set cap " +
+                 std::to_string(budgetBytes / (1024 * 1024)) + "MB)");
+        
+        if (!streamXYZToGaussianLog(content, writer, budgetBytes, stats, progress,
+                                    useSelection ? &selected : nullptr, capture)) {
+            if (!isCancelled(progress)) {
+                LOG_ERROR("Failed to convert to Gaussian log format.");
+            }
+            return false;
+        }
+        
+        LOG_INFO("Found " + std::to_string(stats.frames) + " frame(s), " + std::to_string(stats.atoms) +
+                 " atoms in total; estimated working set " + std::to_string(stats.peakWorkingSet / (1024 * 1024)) + "MB");
+        return true;
+    }
+    
+    LOG_INFO("Processing " + std::to_string(content.length()) + " characters (memory budget " +
+             std::to_string(availableConversionMemory() / (1024 * 1024)) + "MB)");
+    
+    // 校验与解析在同一遍中完成；有帧选择时只解析已选出的帧
+    Trajectory trajectory;
+    TraceSpan parseSpan("parse");
+    bool parsed;
+    if (useSelection) {
+        try {
+            parseXYZFramesParallel(content, selected, trajectory, resolveWorkerThreads(activeConfig().workerThreads),
+                                   progress);
+            parsed = true;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception in parseXYZFramesParallel: " + std::string(e.what()));
+            parsed = false;
+        }
+    } else {
+        parsed = parseXYZContent(content, &trajectory, progress);
+    }
+    parseSpan.end();
+    // 超出预算导致的解析失败由MemoryBudgetScope报告，不应当作格式错误
+    if (isCancelled(progress) || memoryBudgetExceeded()) {
+        return false;
+    }
+    if (!parsed) {
+        LOG_INFO("Invalid XYZ format.");
+        return false;
+    }
+    if (trajectory.frameCount() == 0) {
+        LOG_ERROR("Failed to parse XYZ data.");
+        return false;
+    }
+    if (useSelection && trajectory.frameCount() < selected.size()) {
+        LOG_WARNING("Converted " + std::to_string(trajectory.frameCount()) + " of " + std::to_string(selected.size()) +
+                    " selected frames; the remaining frames could not be read.");
+    }
+    if (inputParsed) inputParsed();
+    
+    LOG_INFO("Found " + std::to_string(trajectory.frameCount()) + " frame(s) with " + std::to_string(trajectory.frameAtomCount(0)) + " atoms.");
+    
+    size_t atomFrames = trajectory.totalAtoms();
+    size_t trajectoryBytes = trajectory.memoryBytes();
+    LOG_DEBUG("Trajectory memory: " + std::to_string(trajectoryBytes) + " bytes for " + std::to_string(atomFrames) +
+              " atom-frames (" + std::to_string(atomFrames ? trajectoryBytes / atomFrames : 0) + " bytes per atom-frame)");
+    
+    TraceSpan convertSpan("convert");
+    std::string gaussianContent = convertToGaussianLog(trajectory);
+    convertSpan.end();
+    if (gaussianContent.empty()) {
+        LOG_ERROR("Failed to convert to Gaussian log format.");
+        return false;
+    }
+    
+    if (isCancelled(progress)) {
+        return false;
+    }
+    
+    TraceSpan writeSpan("temp_file_write");
+    writer.preallocate(gaussianContent.size());
+    if (!writer.write(gaussianContent) || !writer.close()) {
+        LOG_ERROR("Failed to write converted file.");
+        return false;
+    }
+    writeSpan.end();
+    
+    stats.frames = trajectory.frameCount();
+    stats.atoms = trajectory.totalAtoms();
+    stats.bytesWritten = gaussianContent.size();
+    stats.peakWorkingSet = trajectoryBytes + gaussianContent.capacity();
+    if (progress) progress->framesWritten.store(trajectory.frameCount());
+    if (capture) {
+        TraceSpan captureSpan("binary_capture");
+        capture->append(trajectory);
+    }
+    return true;
+}
+
+// 从已打开的二进制轨迹转换：按帧选择取帧，流式写入已创建的writer。失败原因已记录日志
+bool convertBinaryTrajectoryToGaussianLog(const BinaryTrajectoryReader& reader, OutputFileWriter& writer,
+                                          const FrameSelection& selection, StreamStats& stats,
+                                          ConversionProgress* progress) {
+    size_t budgetAtoms = availableConversionMemory() / STREAM_BYTES_PER_ATOM;
+    size_t stride;
+    std::vector<size_t> frames = selectFrameIndices(reader.frameCount(),
+                                                    [&](size_t i) { return reader.frameAtomCount(i); },
+                                                    selection, budgetAtoms, stride);
+    if (selection.active()) {
+        LOG_INFO("Selected " + std::to_string(frames.size()) + " of " + std::to_string(reader.frameCount()) +
+                 " frames (" + selection.describe() +
+                 (selection.autoStride ? ", stride " + std::to_string(stride) : std::string()) + ")");
+    }
+    if (frames.empty()) {
+        LOG_WARNING("Frame selection matched no frames.");
+        return false;
+    }
+    
+    size_t budgetBytes = availableConversionMemory();
+    if (!streamBinaryTrajectoryToGaussianLog(reader, frames, writer, budgetBytes, stats, progress)) {
+        if (!isCancelled(progress)) {
+            LOG_ERROR("Failed to convert to Gaussian log format.");
+        }
+        return false;
+    }
+    
+    LOG_INFO("Converted " + std::to_string(stats.frames) + " frame(s), " + std::to_string(stats.atoms) +
+             " atoms without parsing; estimated working set " + std::to_string(stats.peakWorkingSet / (1024 * 1024)) + "MB");
+    return true;
+}
+
+bool conversionReadsUntilWritten(std::string_view content, InputFormat format) {
+    switch (format) {
+        case InputFormat::StandardXYZ:
+        case InputFormat::ExtendedXYZ:
+        case InputFormat::SimplifiedXYZ:
+            return activeConfig().streamConversion && startsWithAtomCount(content);
+        case InputFormat::GaussianLog:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 按嗅探出的格式选择解析器，写入已创建的writer（成功时已关闭）。XYZ各变体走convertXYZToGaussianLog，
+// Gaussian clipboard为单帧（忽略帧选择），Gaussian log原样写出。失败原因已记录日志，调用方负责删除文件
+bool convertContentToGaussianLog(std::string_view content, InputFormat format, OutputFileWriter& writer,
+                                 const FrameSelection& selection, StreamStats& stats,
+                                 ConversionProgress* progress, BinaryTrajectoryWriter* capture,
+                                 const std::function<void()>& inputParsed) {
+    switch (format) {
+        case InputFormat::StandardXYZ:
+        case InputFormat::ExtendedXYZ:
+        case InputFormat::SimplifiedXYZ:
+            return convertXYZToGaussianLog(content, writer, selection, stats, progress, capture, inputParsed);
+        
+        case InputFormat::GaussianClipboard: {
+            TraceSpan parseSpan("parse");
+            Trajectory trajectory = parseGaussianClipboardContent(content);
+            parseSpan.end();
+            if (memoryBudgetExceeded()) {
+                return false;
+            }
+            if (trajectory.frameCount() == 0) {
+                LOG_ERROR("Failed to parse Gaussian clipboard data.");
+                return false;
+            }
+            if (inputParsed) inputParsed();
+            
+            TraceSpan convertSpan("convert");
+            std::string gaussianContent = convertToGaussianLog(trajectory);
+            convertSpan.end();
+            if (gaussianContent.empty()) {
+                LOG_ERROR("Failed to convert to Gaussian log format.");
+                return false;
+            }
+            
+            TraceSpan writeSpan("temp_file_write");
+            writer.preallocate(gaussianContent.size());
+            if (!writer.write(gaussianContent) || !writer.close()) {
+                LOG_ERROR("Failed to write converted file.");
+                return false;
+            }
+            writeSpan.end();
+            
+            stats.frames = trajectory.frameCount();
+            stats.atoms = trajectory.totalAtoms();
+            stats.bytesWritten = gaussianContent.size();
+            stats.peakWorkingSet = trajectory.memoryBytes() + gaussianContent.capacity();
+            if (progress) progress->framesWritten.store(trajectory.frameCount());
+            LOG_INFO("Found " + std::to_string(stats.atoms) + " atoms in Gaussian clipboard data.");
+            return true;
+        }
+        
+        case InputFormat::GaussianLog: {
+            TraceSpan writeSpan("temp_file_write");
+            writer.preallocate(content.size());
+            if (!writer.write(content.data(), content.size()) || !writer.close()) {
+                LOG_ERROR("Failed to write converted file.");
+                return false;
+            }
+            writeSpan.end();
+            stats.bytesWritten = content.size();
+            LOG_INFO("Content is already a Gaussian log; passing it through unchanged.");
+            return true;
+        }
+        
+        case InputFormat::BinaryTrajectory:
+            LOG_ERROR("Binary trajectory data must be opened by path.");
+            return false;
+        
+        default:
+            LOG_INFO("Content is not a recognized molecular format.");
+            return false;
+    }
+}
+
+// 二进制轨迹缓存键：剪贴板内容的哈希，再混入格式版本与坐标精度
+uint64_t binaryCacheKey(std::string_view content) {
+    std::string variant = "xyzb-" + std::to_string(BINARY_TRAJECTORY_VERSION) + "|" +
+                          std::to_string(activeConfig().binaryCacheBytes);
+    return xxh64(variant.data(), variant.size(), xxh64(content.data(), content.size()));
+}
+
+// 转换的副产品：创建二进制轨迹写入器，未启用（或缓存关闭）时返回空
+std::unique_ptr<BinaryTrajectoryWriter> beginBinaryCapture() {
+    if (activeConfig().binaryCacheBytes == 0 || !g_conversionCache.enabled()) {
+        return nullptr;
+    }
+    auto capture = std::make_unique<BinaryTrajectoryWriter>(activeConfig().binaryCacheBytes == 8);
+    if (!capture->create()) {
+        LOG_WARNING("Failed to create binary trajectory file, continuing without it");
+        return nullptr;
+    }
+    return capture;
+}
+
+// 完成二进制轨迹并移入缓存；失败只记录警告，不影响转换本身
+void commitBinaryCapture(std::unique_ptr<BinaryTrajectoryWriter>& capture, uint64_t key) {
+    if (!capture) return;
+    std::string file = capture->filePath();
+    size_t frames = capture->frameCount();
+    if (!capture->finish()) {
+        LOG_WARNING("Failed to write binary trajectory cache");
+        return;
+    }
+    
+    std::string cached = g_conversionCache.insert(key, file, ".xyzb");
+    if (cached.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(file, ec);
+        return;
+    }
+    LOG_INFO("Saved binary trajectory (" + std::to_string(frames) + " frames): " + cached);
+}
+
+// 文件开头是否为.xyzb魔数（不要求扩展名）
+bool isBinaryTrajectoryFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BINARY_TRAJECTORY_MAGIC)];
+    return file.read(magic, sizeof(magic)) && isBinaryTrajectory(std::string_view(magic, sizeof(magic)));
+}
+
+// 可按文件路径转换的轨迹：二进制轨迹（按魔数）或扩展名为.xyz的文本文件
+bool isTrajectoryFile(const std::string& path) {
+    std::error_code ec;
+    if (path.empty() || !std::filesystem::is_regular_file(path, ec)) return false;
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".xyz" || isBinaryTrajectoryFile(path);
+}
+
+// 文本（如剪贴板内容）是指向轨迹文件的路径时返回该路径，否则返回空字符串。
+// 路径只占一行，可带引号，也可以是file://URI（Linux文件管理器复制文件时的形式，%XX会被解码）
+std::string trajectoryPathFromText(std::string_view content) {
+    if (content.size() > 4096) return "";
+    size_t first = content.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) return "";
+    size_t last = content.find_last_not_of(" \t\r\n");
+    std::string path(content.substr(first, last - first + 1));
+    if (path.find_first_of("\r\n") != std::string::npos) return "";
+    if (path.size() >= 2 && path.front() == '"' && path.back() == '"') {
+        path = path.substr(1, path.size() - 2);
+    }
+    if (path.compare(0, 7, "file://") == 0) {
+        std::string decoded;
+        for (size_t i = 7; i < path.size(); ++i) {
+            int value;
+            if (path[i] == '%' && i + 2 < path.size() &&
+                std::from_chars(path.data() + i + 1, path.data() + i + 3, value, 16).ptr == path.data() + i + 3) {
+                decoded += static_cast<char>(value);
+                i += 2;
+            } else {
+                decoded += path[i];
+            }
+        }
+        path = decoded;
+    }
+    
+    return isTrajectoryFile(path) ? path : "";
+}
+
+// 文件版本：路径、大小（64位）与修改时间，用作按路径转换的缓存键
+std::string trajectoryFileVersion(const std::string& path) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    return path + "|" + std::to_string(size) + "|" +
+           std::to_string(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+}
+
+// 按路径转换轨迹文件：二进制轨迹直接读取，文本文件映射后按嗅探出的格式原地解析（与剪贴板文本走同一流程）。
+// 失败原因已记录日志
+bool convertTrajectoryFileToGaussianLog(const std::string& path, OutputFileWriter& writer,
+                                        const FrameSelection& selection, StreamStats& stats,
+                                        ConversionProgress* progress) {
+    if (isBinaryTrajectoryFile(path)) {
+        BinaryTrajectoryReader reader;
+        TraceSpan openSpan("binary_open");
+        if (!reader.open(path)) {
+            return false;
+        }
+        openSpan.end();
+        LOG_INFO("Loaded binary trajectory " + path + " (" + std::to_string(reader.frameCount()) + " frames, " +
+                 std::to_string(reader.totalAtoms()) + " atoms, " + (reader.doublePrecision() ? "float64" : "float32") + ")");
+        return convertBinaryTrajectoryToGaussianLog(reader, writer, selection, stats, progress);
+    }
+    
+    MappedFile input;
+    TraceSpan mapSpan("input_map");
+    if (!input.open(path)) {
+        return false;
+    }
+    mapSpan.end();
+    LOG_INFO("Mapped " + path + " (" + std::to_string(input.size()) + " bytes)");
+    
+    std::string_view content(input.data(), input.size());
+    FormatGuess guess = sniffFormat(content);
+    if (guess.format == InputFormat::Unknown) {
+        LOG_INFO("File is not a recognized molecular format: " + path);
+        return false;
+    }
+    return convertContentToGaussianLog(content, guess.format, writer, selection, stats, progress);
+}
+
+// CF_TEXT文本的长度：分配大小通常只比文本多出结束符和对齐字节，只在末尾一段中查找结束符；
+// 这一段以NUL开头（分配远大于文本）或没有NUL时，结束符在更前面，才从头查找
+size_t clipboardTextLength(const char* data, size_t capacity) {
+    const size_t TAIL_BYTES = 4096;
+    size_t tailStart = capacity > TAIL_BYTES ? capacity - TAIL_BYTES : 0;
+    const char* tail = data + tailStart;
+    const char* terminator = static_cast<const char*>(std::memchr(tail, '\0', capacity - tailStart));
+    if (terminator && (terminator != tail || tailStart == 0)) {
+        return static_cast<size_t>(terminator - data);
+    }
+    
+    const char* earlier = static_cast<const char*>(std::memchr(data, '\0', tailStart));
+    if (earlier) return static_cast<size_t>(earlier - data);
+    return terminator ? tailStart : capacity;
+}
+
+bool statFile(const std::string& path, uintmax_t& size, std::filesystem::file_time_type& modified) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    modified = std::filesystem::last_write_time(path, ec);
+    return !ec;
+}
+
+// 文件与缓存版本不一致时重新解析
+void ClipboardFileWatcher::refreshIfChanged(const std::string& file) {
+    uintmax_t size;
+    std::filesystem::file_time_type modified;
+    if (!statFile(file, size, modified)) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cached && cached->path == file && cached->size == size && cached->modified == modified) return;
+    }
+    LOG_DEBUG("Gaussian clipboard file changed, re-parsing in background");
+    // 监视线程与任务线程一样按快照读取配置
+    ConfigScope configScope(snapshotConfig());
+    if (refresh(file)) {
+        backgroundParses.fetch_add(1);
+    }
+}
+
+void ClipboardFileWatcher::run(std::string file) {
+    std::string directory = std::filesystem::path(file).parent_path().string();
+    if (directory.empty()) directory = ".";
+    refreshIfChanged(file);
+    
+#ifdef _WIN32
+    HANDLE change = FindFirstChangeNotificationA(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (change == INVALID_HANDLE_VALUE) {
+        LOG_WARNING("Cannot watch directory " + directory + " (Error: " + std::to_string(GetLastError()) + ")");
+        return;
+    }
+    HANDLE handles[2] = {change, stopEvent};
+    while (!stopping) {
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (result != WAIT_OBJECT_0) break;
+        // 去抖：等待写入结束，期间的通知合并处理
+        if (WaitForSingleObject(stopEvent, DEBOUNCE_MS) == WAIT_OBJECT_0) break;
+        FindNextChangeNotification(change);
+        refreshIfChanged(file);
+    }
+    FindCloseChangeNotification(change);
+#else
+    int fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0 || inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY | IN_CREATE) < 0) {
+        LOG_WARNING("Cannot watch directory " + directory + " (" + std::strerror(errno) + ")");
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+    
+    char events[4096];
+    pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+    while (!stopping) {
+        int ready = ::poll(fds, 2, -1);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0 || (fds[1].revents & POLLIN)) break;
+        // 去抖：读空事件，直到一段时间内没有新事件
+        do {
+            while (::read(fd, events, sizeof(events)) > 0) {
+            }
+        } while (!stopping && ::poll(fds, 1, DEBOUNCE_MS) > 0);
+        if (!stopping) refreshIfChanged(file);
+    }
+    ::close(fd);
+#endif
+}
+
+std::shared_ptr<const ParsedClipboardFile> ClipboardFileWatcher::refresh(const std::string& file, bool formatText) {
+    auto parsed = std::make_shared<ParsedClipboardFile>();
+    parsed->path = file;
+    bool versioned = statFile(file, parsed->size, parsed->modified);
+    TraceSpan parseSpan("clipboard_file_parse");
+    parsed->atoms = parseGaussianClipboard(file);
+    parseSpan.end();
+    if (parsed->atoms.totalAtoms() == 0) {
+        return nullptr;
+    }
+    if (formatText) {
+        TraceSpan createSpan("create_xyz");
+        parsed->xyz = createXYZString(parsed->atoms);
+        createSpan.end();
+    }
+    
+    // 解析期间文件又被改写时不缓存（下一次通知会重新解析）
+    uintmax_t size;
+    std::filesystem::file_time_type modified;
+    if (versioned && statFile(file, size, modified) && size == parsed->size && modified == parsed->modified) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cached = parsed;
+    }
+    return parsed;
+}
+
+std::shared_ptr<const ParsedClipboardFile> ClipboardFileWatcher::current(const std::string& file) {
+    uintmax_t size;
+    std::filesystem::file_time_type modified;
+    if (!statFile(file, size, modified)) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cached && cached->path == file && cached->size == size && cached->modified == modified) {
+        return cached;
+    }
+    return nullptr;
+}
+
+void ClipboardFileWatcher::start(const std::string& file) {
+    stop();
+    if (file.empty()) return;
+    stopping = false;
+#ifdef _WIN32
+    stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!stopEvent) return;
+#else
+    if (::pipe(wakeFds) != 0) return;
+#endif
+    LOG_DEBUG("Watching Gaussian clipboard file: " + file);
+    worker = std::thread(&ClipboardFileWatcher::run, this, file);
+}
+
+void ClipboardFileWatcher::stop() {
+    stopping = true;
+#ifdef _WIN32
+    if (stopEvent) SetEvent(stopEvent);
+#else
+    if (wakeFds[1] >= 0) {
+        char wake = 1;
+        if (::write(wakeFds[1], &wake, 1) < 0) {
+            LOG_DEBUG("Failed to wake clipboard file watcher");
+        }
+    }
+#endif
+    if (worker.joinable()) {
+        worker.join();
+    }
+#ifdef _WIN32
+    if (stopEvent) {
+        CloseHandle(stopEvent);
+        stopEvent = NULL;
+    }
+#else
+    for (int& fd : wakeFds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+#endif
+}
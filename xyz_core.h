@@ -0,0 +1,1742 @@
+// xyz_core.h - 可移植的转换核心：日志、配置、XYZ/Gaussian解析与格式化、临时文件、缓存与二进制轨迹。
+// 不依赖Win32界面，托盘程序（xyz_monitor.cpp）与命令行工具（xyzconv.cpp）共用
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <ctime>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <list>
+#include <new>
+#include <cstdlib>
+#include <cmath>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+// 解决Windows ERROR宏冲突
+#ifdef ERROR
+#undef ERROR
+#endif
+
+// 日志级别枚举
+enum class LogLevel {
+    DEBUG = 0,
+    INFO = 1,
+    WARNING = 2,
+    ERROR = 3
+};
+
+// 日志类。异步模式下生产者把定长记录写入无锁MPSC环形缓冲区（Vyukov有界队列），
+// 后台线程批量输出到控制台和文件、定期刷新，并缓存时间戳的格式化结果。
+// ERROR级别的日志会等待写出；未启动异步模式（或已关闭）时在调用线程上同步输出
+class Logger {
+private:
+    // 环形缓冲区中的定长记录，超长消息截断
+    static constexpr size_t RECORD_TEXT = 480;
+    static constexpr size_t RING_CAPACITY = 4096;  // 2的幂
+    static constexpr int FLUSH_INTERVAL_MS = 1000;
+    static constexpr int IDLE_WAIT_MS = 100;
+    
+    struct Record {
+        std::atomic<size_t> sequence;
+        std::time_t time;
+        LogLevel level;
+        uint32_t length;
+        char text[RECORD_TEXT];
+    };
+    
+    std::ofstream logFile;
+    std::mutex outputMutex;
+    std::atomic<LogLevel> currentLevel;
+    std::atomic<bool> logToConsole;
+    std::atomic<bool> logToFile;
+    
+    // 异步输出
+    std::unique_ptr<Record[]> ring;
+    std::atomic<size_t> enqueuePos{0};
+    size_t dequeuePos = 0;  // 只由输出线程访问
+    std::thread flusher;
+    std::atomic<bool> asyncRunning{false};
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> flusherIdle{false};
+    std::atomic<bool> blockWhenFull{true};
+    std::atomic<size_t> droppedRecords{0};
+    std::atomic<int> activeProducers{0};  // 已看到异步模式、尚未写完记录的生产者
+    std::atomic<uint64_t> flushRequests{0};
+    uint64_t flushesCompleted = 0;  // 受wakeMutex保护
+    std::mutex wakeMutex;
+    std::condition_variable wakeup;
+    std::condition_variable flushed;
+    
+    // 时间戳缓存（同一秒内复用格式化结果）
+    std::time_t cachedSecond = -1;
+    char cachedStamp[32] = {0};
+    
+    // 输出批次
+    std::string consoleBatch;
+    std::string fileBatch;
+    
+    static const char* levelTag(LogLevel level);
+    
+    // 组装消息正文：消息本身，错误和警告附加文件名与行号；超出capacity时截断
+    static size_t composeText(char* out, size_t capacity, LogLevel level, std::string_view message,
+                              const char* file, int line);
+    
+    const char* stamp(std::time_t time);
+    
+    // 追加一行到输出批次；ERROR写到stderr，写之前先输出已缓冲的stdout内容以保持顺序
+    void appendLine(LogLevel level, std::time_t time, std::string_view text);
+    
+    void writeConsole();
+    
+    void writeBatches(bool flushFile);
+    
+    bool tryEnqueue(LogLevel level, std::string_view message, const char* file, int line);
+    
+    // 输出线程调用：是否有已发布但未取出的记录
+    bool hasPending() const {
+        const Record& record = ring[dequeuePos & (RING_CAPACITY - 1)];
+        return record.sequence.load(std::memory_order_acquire) == dequeuePos + 1;
+    }
+    
+    // 取出当前所有已发布的记录并追加到输出批次，返回取出的条数
+    size_t drain(bool& sawError);
+    
+    void run();
+    
+    void wakeFlusher() {
+        if (flusherIdle.load(std::memory_order_relaxed)) {
+            wakeup.notify_one();
+        }
+    }
+    
+    void logSync(LogLevel level, std::string_view message, const char* file, int line);
+
+public:
+    Logger() : currentLevel(LogLevel::INFO), logToConsole(true), logToFile(true) {}
+    
+    ~Logger();
+    
+    bool initialize(const std::string& logFilePath, LogLevel level = LogLevel::INFO);
+    
+    void setLogToConsole(bool enabled) {
+        logToConsole = enabled;
+    }
+    
+    void setLogToFile(bool enabled) {
+        logToFile = enabled;
+    }
+    
+    void setLogLevel(LogLevel level) {
+        currentLevel = level;
+    }
+    
+    // 级别检查：日志宏在构建消息之前调用，被过滤的级别不产生任何字符串开销
+    bool isEnabled(LogLevel level) const {
+        return level >= currentLevel.load(std::memory_order_relaxed);
+    }
+    
+    void log(LogLevel level, const std::string& message, const char* file = nullptr, int line = 0);
+    
+    // 启动异步输出线程；blockOnFull为false时缓冲区满则丢弃新消息（并在之后报告丢弃数）
+    void startAsync(bool blockOnFull);
+    
+    // 等待此前的日志全部写出并刷新文件（最多等待5秒，输出线程异常时不会卡住调用者）
+    void flush();
+    
+    // 停止异步输出：写出缓冲区中剩余的日志后回到同步模式
+    void shutdown();
+    
+    // printf风格的日志接口：短消息格式化到栈上缓冲区，只有超长消息才分配
+#if defined(__GNUC__)
+    __attribute__((format(printf, 5, 6)))
+#endif
+    void logf(LogLevel level, const char* file, int line, const char* format, ...);
+};
+
+// 全局日志实例
+extern Logger g_logger;
+
+// 日志宏定义：先检查级别，被过滤时不会求值消息表达式。
+// LOG_xxxF为printf风格。定义XYZ_STRIP_DEBUG_LOG（make STRIP_DEBUG_LOG=1）时DEBUG日志在编译期去除
+#define LOG_AT(level, file, line, msg) \
+    do { if (g_logger.isEnabled(level)) g_logger.log(level, msg, file, line); } while (0)
+#define LOG_AT_F(level, file, line, ...) \
+    do { if (g_logger.isEnabled(level)) g_logger.logf(level, file, line, __VA_ARGS__); } while (0)
+
+#ifdef XYZ_STRIP_DEBUG_LOG
+#define LOG_DEBUG(msg) do { if (false) { (void)(msg); } } while (0)
+#define LOG_DEBUGF(...) do { if (false) { std::printf(__VA_ARGS__); } } while (0)
+#else
+#define LOG_DEBUG(msg) LOG_AT(LogLevel::DEBUG, __FILE__, __LINE__, msg)
+#define LOG_DEBUGF(...) LOG_AT_F(LogLevel::DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#endif
+#define LOG_INFO(msg) LOG_AT(LogLevel::INFO, nullptr, 0, msg)
+#define LOG_INFOF(...) LOG_AT_F(LogLevel::INFO, nullptr, 0, __VA_ARGS__)
+#define LOG_WARNING(msg) LOG_AT(LogLevel::WARNING, __FILE__, __LINE__, msg)
+#define LOG_WARNINGF(...) LOG_AT_F(LogLevel::WARNING, __FILE__, __LINE__, __VA_ARGS__)
+#define LOG_ERROR(msg) LOG_AT(LogLevel::ERROR, __FILE__, __LINE__, msg)
+#define LOG_ERRORF(...) LOG_AT_F(LogLevel::ERROR, __FILE__, __LINE__, __VA_ARGS__)
+
+// 帧选择（仅对多帧标准XYZ生效）：先取区间[start, stop)，再取其中最后lastN帧，最后按步长抽取
+struct FrameSelection {
+    size_t start = 0;
+    size_t stop = 0;          // 0表示到最后一帧
+    size_t lastN = 0;         // 0表示不限
+    size_t stride = 1;
+    bool autoStride = false;  // 按max_memory_mb自动选择最小步长
+    
+    bool active() const {
+        return start > 0 || stop > 0 || lastN > 0 || stride > 1 || autoStride;
+    }
+    
+    std::string describe() const {
+        if (!active()) return "all";
+        std::string text;
+        if (start > 0 || stop > 0) {
+            text += "range=" + std::to_string(start) + ":" + (stop > 0 ? std::to_string(stop) : std::string());
+        }
+        if (lastN > 0) {
+            text += (text.empty() ? "" : ",") + std::string("last=") + std::to_string(lastN);
+        }
+        if (autoStride) {
+            text += (text.empty() ? "" : ",") + std::string("stride=auto");
+        } else if (stride > 1) {
+            text += (text.empty() ? "" : ",") + std::string("stride=") + std::to_string(stride);
+        }
+        return text;
+    }
+};
+
+// 配置结构体
+struct Config {
+    std::string hotkey = "CTRL+SHIFT+V";
+    std::string hotkeyReverse = "CTRL+SHIFT+G";  // 新增：反向转换热键
+    std::string gviewPath = "";
+    std::string tempDir = "";
+    std::string logFile = "logs/xyz_monitor.log";
+    std::string gaussianClipboardPath = "";  // 新增：Gaussian clipboard文件路径
+    int waitSeconds = 5;
+    std::string logLevel = "INFO";
+    bool logToConsole = true;
+    bool logToFile = true;
+    // 新增内存配置项
+    int maxMemoryMB = 500;  // 默认500MB
+    size_t maxClipboardChars = 0;  // 0表示不限制
+    bool clipboardBorrow = true;  // 整体转换在解析期间借用剪贴板文本（流式转换总是先复制）；false时总是复制一次后立即归还剪贴板
+    // 工作线程数（0表示按CPU核心数自动选择，1表示单线程）
+    int workerThreads = 0;
+    // 流式转换：分批解析并立即写入临时文件，max_memory_mb作为工作集上限
+    bool streamConversion = true;
+    int writeBufferKB = 1024;  // 临时文件写缓冲区大小（按4KB对齐）
+    // 帧选择，以及按覆盖热键时使用的帧选择（默认全部帧）
+    FrameSelection frameSelection;
+    std::string hotkeyOverride = "CTRL+SHIFT+ALT+V";
+    FrameSelection overrideSelection;
+    // 转换结果缓存（temp_dir中按内容哈希保存的log文件），大小或条目数为0时禁用
+    int cacheMaxMB = 256;
+    int cacheMaxEntries = 8;
+    // 转换时顺带写入缓存的二进制轨迹（.xyzb）的坐标字节数：4 = float32，8 = float64，0 = 不写入
+    int binaryCacheBytes = 4;
+    // 查看器打开文件（进程进入空闲）后即删除临时文件，不再固定等待wait_seconds
+    bool deleteWhenOpened = false;
+    // 监视Gaussian clipboard文件，变化时在后台预解析
+    bool watchGaussianClipboard = true;
+    // 异步日志：后台线程批量写出；队列满时阻塞（block）或丢弃（drop）
+    bool logAsync = true;
+    bool logBlockWhenFull = true;
+    // 每次转换的阶段计时区间导出为Chrome/Perfetto trace JSON文件（写入trace_dir）
+    bool traceConversions = false;
+    std::string traceDir = "logs/traces";
+};
+
+// 全局配置：由界面线程加载与重新加载（loadConfig在锁内整体替换），其他线程通过快照读取
+extern Config g_config;
+
+// 在锁内复制g_config，得到后台任务使用的只读快照
+std::shared_ptr<const Config> snapshotConfig();
+
+// 当前线程的活动配置快照（parallelFor的工作线程在执行任务期间使用调用线程的快照）
+inline thread_local const Config* t_activeConfig = nullptr;
+
+// 当前线程应读取的配置：后台任务执行期间为任务开始时的快照，否则为g_config
+inline const Config& activeConfig() {
+    return t_activeConfig ? *t_activeConfig : g_config;
+}
+
+// 在作用域内持有配置快照并设为当前线程的活动配置，重新加载配置不影响正在执行的任务
+class ConfigScope {
+private:
+    std::shared_ptr<const Config> config;
+    const Config* previous;
+
+public:
+    explicit ConfigScope(std::shared_ptr<const Config> snapshot)
+        : config(std::move(snapshot)), previous(t_activeConfig) {
+        t_activeConfig = config.get();
+    }
+    
+    ~ConfigScope() {
+        t_activeConfig = previous;
+    }
+    
+    ConfigScope(const ConfigScope&) = delete;
+    ConfigScope& operator=(const ConfigScope&) = delete;
+};
+
+// 轨迹结构体（结构数组布局）
+// 元素符号驻留为ID，拓扑（每个原子的元素ID序列）只在变化时存一份；
+// 坐标按帧连续存放在x/y/z数组中，frameOffsets[i]..frameOffsets[i+1]为第i帧的原子范围
+struct Trajectory {
+    std::vector<std::string> elements;                 // 元素ID -> 原始符号
+    std::unordered_map<std::string, uint32_t> elementIds;
+    std::vector<std::vector<uint32_t>> topologies;     // 去重后的拓扑
+    std::vector<uint32_t> frameTopology;               // 每帧使用的拓扑下标
+    std::vector<size_t> frameOffsets = {0};
+    std::vector<double> x, y, z;
+    std::vector<std::string> comments;
+    std::vector<uint32_t> pending;                     // 正在构建的帧的元素ID
+    
+    size_t frameCount() const {
+        return frameTopology.size();
+    }
+    
+    size_t totalAtoms() const {
+        return x.size();
+    }
+    
+    size_t frameAtomCount(size_t frame) const {
+        return frameOffsets[frame + 1] - frameOffsets[frame];
+    }
+    
+    const std::vector<uint32_t>& frameElements(size_t frame) const {
+        return topologies[frameTopology[frame]];
+    }
+    
+    uint32_t internElement(std::string_view symbol) {
+        // 快速路径：与上一拓扑同位置的原子符号相同（轨迹中几乎总是如此）
+        if (!topologies.empty()) {
+            const std::vector<uint32_t>& previous = topologies.back();
+            size_t index = pending.size();
+            if (index < previous.size() && elements[previous[index]] == symbol) {
+                return previous[index];
+            }
+        }
+        
+        return addElement(symbol);
+    }
+    
+    // 查找或登记元素符号（不走拓扑快速路径）
+    uint32_t addElement(std::string_view symbol) {
+        std::string key(symbol);
+        auto it = elementIds.find(key);
+        if (it != elementIds.end()) {
+            return it->second;
+        }
+        
+        uint32_t id = static_cast<uint32_t>(elements.size());
+        elements.push_back(key);
+        elementIds.emplace(std::move(key), id);
+        return id;
+    }
+    
+    // 只读查找（可在多个线程中并发调用）；index为原子在帧内的位置，
+    // 优先与最后一个拓扑同位置比较。未登记的符号返回UNKNOWN_ELEMENT
+    static constexpr uint32_t UNKNOWN_ELEMENT = 0xFFFFFFFFu;
+    uint32_t findElement(std::string_view symbol, size_t index) const {
+        if (!topologies.empty()) {
+            const std::vector<uint32_t>& previous = topologies.back();
+            if (index < previous.size() && elements[previous[index]] == symbol) {
+                return previous[index];
+            }
+        }
+        auto it = elementIds.find(std::string(symbol));
+        return it != elementIds.end() ? it->second : UNKNOWN_ELEMENT;
+    }
+    
+    void reserveAtoms(size_t count) {
+        x.reserve(count);
+        y.reserve(count);
+        z.reserve(count);
+    }
+    
+    void beginFrame(std::string_view comment) {
+        pending.clear();
+        comments.emplace_back(comment);
+    }
+    
+    void addAtom(std::string_view symbol, double ax, double ay, double az) {
+        pending.push_back(internElement(symbol));
+        x.push_back(ax);
+        y.push_back(ay);
+        z.push_back(az);
+    }
+    
+    size_t pendingAtomCount() const {
+        return pending.size();
+    }
+    
+    void endFrame() {
+        if (topologies.empty() || topologies.back() != pending) {
+            topologies.push_back(pending);
+        }
+        frameTopology.push_back(static_cast<uint32_t>(topologies.size() - 1));
+        frameOffsets.push_back(x.size());
+        pending.clear();
+    }
+    
+    // 丢弃正在构建的帧
+    void cancelFrame() {
+        size_t start = frameOffsets.back();
+        x.resize(start);
+        y.resize(start);
+        z.resize(start);
+        comments.pop_back();
+        pending.clear();
+    }
+    
+    // 清空所有帧但保留元素表和最后一个拓扑（流式转换在批次之间复用，保持查找快速路径）
+    void clearFrames() {
+        if (topologies.size() > 1) {
+            topologies.erase(topologies.begin(), topologies.end() - 1);
+        }
+        frameTopology.clear();
+        frameOffsets.assign(1, 0);
+        x.clear();
+        y.clear();
+        z.clear();
+        comments.clear();
+        pending.clear();
+    }
+    
+    // 估算常驻内存（按容量计算）
+    size_t memoryBytes() const {
+        size_t bytes = sizeof(Trajectory);
+        bytes += (x.capacity() + y.capacity() + z.capacity()) * sizeof(double);
+        bytes += frameOffsets.capacity() * sizeof(size_t);
+        bytes += frameTopology.capacity() * sizeof(uint32_t);
+        bytes += pending.capacity() * sizeof(uint32_t);
+        for (const auto& topology : topologies) {
+            bytes += sizeof(topology) + topology.capacity() * sizeof(uint32_t);
+        }
+        for (const auto& comment : comments) {
+            bytes += sizeof(comment) + (comment.capacity() > 15 ? comment.capacity() + 1 : 0);
+        }
+        bytes += elements.capacity() * sizeof(std::string) * 2;
+        return bytes;
+    }
+};
+
+// 元素符号表（下标为原子序数，1-118）
+inline constexpr int MAX_ATOMIC_NUMBER = 118;
+inline constexpr const char* ELEMENT_SYMBOLS[MAX_ATOMIC_NUMBER + 1] = {
+    "",
+    "H", "He", "Li", "Be", "B", "C", "N", "O", "F", "Ne",
+    "Na", "Mg", "Al", "Si", "P", "S", "Cl", "Ar", "K", "Ca",
+    "Sc", "Ti", "V", "Cr", "Mn", "Fe", "Co", "Ni", "Cu", "Zn",
+    "Ga", "Ge", "As", "Se", "Br", "Kr", "Rb", "Sr", "Y", "Zr",
+    "Nb", "Mo", "Tc", "Ru", "Rh", "Pd", "Ag", "Cd", "In", "Sn",
+    "Sb", "Te", "I", "Xe", "Cs", "Ba", "La", "Ce", "Pr", "Nd",
+    "Pm", "Sm", "Eu", "Gd", "Tb", "Dy", "Ho", "Er", "Tm", "Yb",
+    "Lu", "Hf", "Ta", "W", "Re", "Os", "Ir", "Pt", "Au", "Hg",
+    "Tl", "Pb", "Bi", "Po", "At", "Rn", "Fr", "Ra", "Ac", "Th",
+    "Pa", "U", "Np", "Pu", "Am", "Cm", "Bk", "Cf", "Es", "Fm",
+    "Md", "No", "Lr", "Rf", "Db", "Sg", "Bh", "Hs", "Mt", "Ds",
+    "Rg", "Cn", "Nh", "Fl", "Mc", "Lv", "Ts", "Og"
+};
+
+// 两字符直接索引：[首字母A-Z][次字母a-z，26表示单字母符号] -> 原子序数，编译期生成
+struct ElementIndex {
+    uint8_t table[26][27];
+};
+
+constexpr ElementIndex buildElementIndex() {
+    ElementIndex index{};
+    for (int z = 1; z <= MAX_ATOMIC_NUMBER; ++z) {
+        const char* symbol = ELEMENT_SYMBOLS[z];
+        int second = symbol[1] ? symbol[1] - 'a' : 26;
+        index.table[symbol[0] - 'A'][second] = static_cast<uint8_t>(z);
+    }
+    return index;
+}
+
+inline constexpr ElementIndex ELEMENT_INDEX = buildElementIndex();
+
+// 原子序数 -> 元素符号，超出范围返回nullptr
+constexpr const char* elementSymbol(int atomicNumber) {
+    return (atomicNumber >= 1 && atomicNumber <= MAX_ATOMIC_NUMBER) ? ELEMENT_SYMBOLS[atomicNumber] : nullptr;
+}
+
+// 按一个或两个字母查元素（不区分大小写），second为0表示单字母符号；未知返回0
+constexpr int lookupElement(char first, char second) {
+    char upper = (first >= 'a' && first <= 'z') ? static_cast<char>(first - 'a' + 'A') : first;
+    char lower = (second >= 'A' && second <= 'Z') ? static_cast<char>(second - 'A' + 'a') : second;
+    if (upper < 'A' || upper > 'Z') return 0;
+    if (second == 0) return ELEMENT_INDEX.table[upper - 'A'][26];
+    if (lower < 'a' || lower > 'z') return 0;
+    return ELEMENT_INDEX.table[upper - 'A'][lower - 'a'];
+}
+
+static_assert(lookupElement('C', 0) == 6 && lookupElement('c', 'L') == 17 && lookupElement('O', 'g') == 118,
+              "element index is inconsistent with the symbol table");
+
+// 获取原子序数：元素符号（不区分大小写）、带编号或后缀的标签、PDB式氢原子名（HA、HB2），
+// 或数字形式的原子序数；无法识别时（含虚原子Bq、X、Gh）返回0
+int getAtomicNumber(std::string_view symbol);
+
+// 配置：读取config.ini（不存在时写出默认文件并返回false），以及各配置项的解析
+LogLevel stringToLogLevel(const std::string& levelStr);
+bool loadConfig(const std::string& configFile);
+bool parseFrameRange(const std::string& value, FrameSelection& selection);
+bool parseFrameStride(const std::string& value, FrameSelection& selection);
+bool parseFrameSelection(const std::string& spec, FrameSelection& selection);
+
+// 工具函数
+std::string trim(const std::string& str);
+std::vector<std::string> split(const std::string& str, char delim);
+std::string_view trimView(std::string_view str);
+bool nextRawLine(std::string_view text, size_t& pos, std::string_view& line);
+size_t splitWhitespaceView(std::string_view str, std::string_view* tokens, size_t maxTokens);
+bool parseDouble(std::string_view str, double& value);
+bool parseInt(std::string_view str, int& value);
+unsigned resolveWorkerThreads(int configured);
+uint64_t xxh64(const void* data, size_t length, uint64_t seed = 0);
+
+// 定宽6位小数格式化的最大输出长度（|v|接近DBL_MAX时整数部分有309位）
+inline constexpr size_t FIXED6_MAX_CHARS = 330;
+char* formatFixed6(char* out, double value, int width);
+size_t fixed6Length(double value, int width);
+
+// ===== 内存记账 =====
+// 全局operator new/delete（xyz_alloc_hook.cpp，只由可执行程序链接）在每块内存前记录大小及所属预算，
+// 分配时把大小计入当前线程的活动预算。预算的计数器放在固定的槽表中，块在预算结束后才释放时按代号识别并忽略，
+// 不会访问已销毁的对象。没有链接分配钩子的程序中预算不占用槽（tracking()为false），不统计也不限制
+
+struct MemoryBudgetSlot {
+    std::atomic<bool> inUse{false};
+    std::atomic<uint32_t> generation{0};
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> peak{0};
+    std::atomic<int64_t> stagePeak{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+    int64_t limit = 0;                         // 0表示不限制
+    std::atomic<bool> exceeded{false};
+    std::atomic<const char*> stage{nullptr};   // 当前阶段（TraceSpan设置）
+    const char* exceededStage = nullptr;
+};
+
+inline constexpr uint32_t MEMORY_BUDGET_SLOTS = 64;
+
+// 分配钩子在静态初始化时调用enableMemoryAccounting()
+void enableMemoryAccounting();
+bool memoryAccountingEnabled();
+MemoryBudgetSlot* acquireMemoryBudgetSlot(int64_t limit, uint32_t& generation);
+void releaseMemoryBudgetSlot(MemoryBudgetSlot* slot);
+MemoryBudgetSlot& memoryBudgetSlot(uint32_t index);
+bool chargeMemoryBudget(MemoryBudgetSlot& slot, size_t size);
+
+// 一次转换的内存预算：统计活跃字节数、峰值与分配次数。超出上限的那次分配抛出std::bad_alloc，
+// 转换随之展开并干净地失败；之后不再限制（清理与日志仍可分配），只继续统计
+class MemoryBudget {
+private:
+    uint32_t generation = 0;  // 须在slot之前声明：slot的初始化会写入它
+    MemoryBudgetSlot* slot;
+
+public:
+    explicit MemoryBudget(size_t limitBytes) : slot(acquireMemoryBudgetSlot(static_cast<int64_t>(limitBytes), generation)) {}
+    
+    ~MemoryBudget() {
+        releaseMemoryBudgetSlot(slot);
+    }
+    
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+    
+    bool tracking() const {
+        return slot != nullptr;
+    }
+    
+    uint32_t slotIndex() const;
+    
+    uint32_t slotGeneration() const {
+        return generation;
+    }
+    
+    size_t limit() const {
+        return slot ? static_cast<size_t>(slot->limit) : 0;
+    }
+    
+    size_t live() const {
+        return slot ? static_cast<size_t>(std::max<int64_t>(0, slot->live.load(std::memory_order_relaxed))) : 0;
+    }
+    
+    size_t peak() const {
+        return slot ? static_cast<size_t>(slot->peak.load(std::memory_order_relaxed)) : 0;
+    }
+    
+    uint64_t allocations() const {
+        return slot ? slot->allocations.load(std::memory_order_relaxed) : 0;
+    }
+    
+    uint64_t allocatedBytes() const {
+        return slot ? slot->allocatedBytes.load(std::memory_order_relaxed) : 0;
+    }
+    
+    bool exceeded() const {
+        return slot && slot->exceeded.load(std::memory_order_relaxed);
+    }
+    
+    // 超出上限时所在的阶段（没有阶段信息时为nullptr）
+    const char* exceededStage() const {
+        return exceeded() ? slot->exceededStage : nullptr;
+    }
+    
+    // 剩余可用字节数；不限制时返回fallback
+    size_t remaining(size_t fallback) const {
+        if (!slot || slot->limit == 0) return fallback;
+        return static_cast<size_t>(std::max<int64_t>(0, slot->limit - slot->live.load(std::memory_order_relaxed)));
+    }
+    
+    // 阶段峰值：进入阶段时以当前活跃字节数为起点，离开时返回阶段内的峰值并合并回外层阶段
+    struct StageMark {
+        int64_t outerPeak;
+        const char* outerStage;
+    };
+    
+    StageMark enterStage(const char* name) {
+        StageMark mark = {slot->stagePeak.load(std::memory_order_relaxed), slot->stage.load(std::memory_order_relaxed)};
+        slot->stagePeak.store(slot->live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        slot->stage.store(name, std::memory_order_relaxed);
+        return mark;
+    }
+    
+    size_t leaveStage(const StageMark& mark) {
+        int64_t stagePeak = slot->stagePeak.load(std::memory_order_relaxed);
+        slot->stagePeak.store(std::max(mark.outerPeak, stagePeak), std::memory_order_relaxed);
+        slot->stage.store(mark.outerStage, std::memory_order_relaxed);
+        return static_cast<size_t>(std::max<int64_t>(0, stagePeak));
+    }
+};
+
+// 当前线程的活动预算（parallelFor的工作线程在执行任务期间使用调用线程的预算）
+inline thread_local MemoryBudget* t_activeBudget = nullptr;
+
+// 转换的内存上限：max_memory_mb
+inline size_t conversionMemoryLimit() {
+    return static_cast<size_t>(activeConfig().maxMemoryMB) * 1024 * 1024;
+}
+
+// 当前转换还能使用的字节数（没有活动预算时为max_memory_mb），用于确定流式批大小与自动步长
+inline size_t availableConversionMemory() {
+    return t_activeBudget ? t_activeBudget->remaining(conversionMemoryLimit()) : conversionMemoryLimit();
+}
+
+// 当前转换的预算是否已超出：超出后的分配会正常进行，转换应在检查点放弃而不是输出部分结果
+inline bool memoryBudgetExceeded() {
+    return t_activeBudget && t_activeBudget->exceeded();
+}
+
+// 在作用域内把预算设为当前线程的活动预算；结束时记录峰值（name非空时），超出上限时记录错误
+class MemoryBudgetScope {
+private:
+    MemoryBudget& budget;
+    MemoryBudget* previous;
+    const char* name;
+
+public:
+    MemoryBudgetScope(MemoryBudget& activeBudget, const char* scopeName)
+        : budget(activeBudget), previous(t_activeBudget), name(scopeName) {
+        if (budget.tracking()) t_activeBudget = &budget;
+    }
+    
+    ~MemoryBudgetScope() {
+        t_activeBudget = previous;
+        if (!name || !budget.tracking()) return;
+        
+        double peakMB = budget.peak() / (1024.0 * 1024.0);
+        double limitMB = budget.limit() / (1024.0 * 1024.0);
+        if (budget.exceeded()) {
+            LOG_ERRORF("Conversion aborted: %s exceeded the %.0fMB memory budget%s%s (max_memory_mb)", name, limitMB,
+                       budget.exceededStage() ? " during " : "", budget.exceededStage() ? budget.exceededStage() : "");
+        } else {
+            LOG_INFOF("Peak memory (%s): %.1fMB of %.0fMB budget, %llu allocations", name, peakMB, limitMB,
+                      static_cast<unsigned long long>(budget.allocations()));
+        }
+    }
+    
+    MemoryBudgetScope(const MemoryBudgetScope&) = delete;
+    MemoryBudgetScope& operator=(const MemoryBudgetScope&) = delete;
+};
+
+// 行游标：与split(content, '\n')的结果一致（修整空格、跳过空行），但只返回缓冲区切片
+class LineCursor {
+private:
+    std::string_view text;
+    size_t pos;
+    size_t count;
+
+public:
+    explicit LineCursor(std::string_view content) : text(content), pos(0), count(0) {}
+    
+    // 从指定字节位置开始，startLine为该位置所在行在split结果中的下标
+    LineCursor(std::string_view content, size_t startPos, size_t startLine)
+        : text(content), pos(startPos), count(startLine) {}
+    
+    bool next(std::string_view& line) {
+        std::string_view raw;
+        while (nextRawLine(text, pos, raw)) {
+            std::string_view trimmed = trimView(raw);
+            if (!trimmed.empty()) {
+                line = trimmed;
+                ++count;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // 最近一次返回的行在split结果中的下标
+    size_t lineIndex() const {
+        return count - 1;
+    }
+    
+    // 下一行的起始字节位置
+    size_t position() const {
+        return pos;
+    }
+};
+
+// 常驻工作线程池：parallelFor把任务交给池中空闲的线程，不再在每次调用时创建和回收线程。
+// 空闲线程不足时按需补充（总数不超过MAX_THREADS），之后保留到程序退出。线程在预算之外创建，
+// 线程状态不计入转换预算；创建失败时只记录警告，由已有线程和调用线程完成任务
+class WorkerPool {
+public:
+    // 一次parallelFor调用。调用线程做完自己的部分后关闭任务：尚未开始的帮助线程不再执行，
+    // 已开始的由调用线程等待结束，因此run引用的调用方栈上对象在返回前一直有效
+    struct Task {
+        std::function<void()> run;
+        MemoryBudget* budget = nullptr;
+        const Config* config = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+        unsigned active = 0;
+        bool closed = false;
+    };
+
+private:
+    static constexpr unsigned MAX_THREADS = 256;
+    
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<Task>> queue;
+    std::vector<std::thread> threads;
+    size_t idle = 0;  // 未在执行任务的线程（含刚创建、尚未开始等待的线程）
+    bool stopping = false;
+    
+    // 执行一张任务票据；先把自己记回空闲再通知调用线程，调用线程随即提交的下一个任务不会因此多建线程
+    void help(Task& task);
+    
+    void workerLoop();
+
+public:
+    WorkerPool() = default;
+    
+    ~WorkerPool();
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    
+    // 请求helpers个线程协助执行task，返回实际排队的数量（可能少于请求数）
+    size_t submit(const std::shared_ptr<Task>& task, size_t helpers);
+    
+    // 关闭任务：撤回还在队列中的票据，并等待已开始的帮助线程结束
+    void finish(const std::shared_ptr<Task>& task);
+    
+    size_t threadCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return threads.size();
+    }
+};
+
+inline WorkerPool& workerPool() {
+    static WorkerPool pool;
+    return pool;
+}
+
+// 并行执行func(i)，i属于[0, count)；调用线程与线程池中的线程按grain大小领取任务块，
+// 工作线程中的异常在全部线程结束后重新抛出。可以嵌套调用：池中没有空闲线程时由调用线程完成
+template <typename Func>
+void parallelFor(size_t count, unsigned threads, size_t grain, Func&& func) {
+    if (grain == 0) grain = 1;
+    if (threads <= 1 || count <= grain) {
+        for (size_t i = 0; i < count; ++i) func(i);
+        return;
+    }
+    
+    size_t maxThreads = (count + grain - 1) / grain;
+    if (threads > maxThreads) threads = static_cast<unsigned>(maxThreads);
+    
+    std::atomic<size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    
+    auto worker = [&]() {
+        try {
+            size_t begin;
+            while ((begin = next.fetch_add(grain)) < count) {
+                size_t end = std::min(count, begin + grain);
+                for (size_t i = begin; i < end; ++i) func(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) failure = std::current_exception();
+            next.store(count);
+        }
+    };
+    
+    auto task = std::make_shared<WorkerPool::Task>();
+    task->run = worker;
+    task->budget = t_activeBudget;
+    task->config = t_activeConfig;
+    workerPool().submit(task, threads - 1);
+    worker();
+    workerPool().finish(task);
+    
+    if (failure) std::rethrow_exception(failure);
+}
+
+// 转换进度：工作线程更新，界面线程读取；cancelled由界面线程设置
+struct ConversionProgress {
+    std::atomic<bool> cancelled{false};
+    std::atomic<size_t> framesParsed{0};
+    std::atomic<size_t> framesWritten{0};
+};
+
+inline bool isCancelled(const ConversionProgress* progress) {
+    return progress && progress->cancelled.load(std::memory_order_relaxed);
+}
+
+// 转换方向
+enum class ConversionDirection {
+    XYZToGView = 0,
+    GViewToXYZ = 1,
+    XYZToGViewOverride = 2  // XYZ到GView，使用覆盖热键的帧选择
+};
+
+// 转换任务队列：单个工作线程按提交顺序执行任务。
+// 同一方向已有排队任务时新的提交被合并；正在执行的任务可以取消。
+// 每个任务开始时取得配置快照，执行期间activeConfig()返回该快照，界面线程可随时重新加载配置。
+// 不依赖Win32，状态变化通过回调通知界面层
+class ConversionJobQueue {
+public:
+    using Runner = std::function<void(ConversionDirection, ConversionProgress&)>;
+    using StateCallback = std::function<void()>;
+    
+    // 当前任务的快照
+    struct Status {
+        bool busy = false;
+        ConversionDirection direction = ConversionDirection::XYZToGView;
+        size_t framesParsed = 0;
+        size_t framesWritten = 0;
+        size_t queued = 0;
+    };
+
+private:
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread worker;
+    std::deque<ConversionDirection> pending;
+    std::shared_ptr<ConversionProgress> current;
+    ConversionDirection currentDirection = ConversionDirection::XYZToGView;
+    bool stopping = false;
+    Runner runner;
+    StateCallback onStateChanged;
+    
+    void run();
+    
+    void notify() {
+        if (onStateChanged) onStateChanged();
+    }
+
+public:
+    ~ConversionJobQueue() {
+        stop();
+    }
+    
+    void start(Runner jobRunner, StateCallback stateCallback);
+    
+    // 提交任务；同一方向已在排队时合并，返回false
+    bool submit(ConversionDirection direction);
+    
+    // 请求取消正在执行的任务；没有任务时返回false
+    bool cancelCurrent();
+    
+    Status status();
+    
+    // 取消当前任务、丢弃排队任务并等待工作线程结束
+    void stop();
+};
+
+// 一次转换的阶段计时：TraceSpan在作用域结束时记录一个区间。finish()把各阶段耗时汇总为一行INFO日志，
+// 启用trace_conversions时另写出Chrome/Perfetto trace JSON（chrome://tracing或ui.perfetto.dev打开）
+class ConversionTrace {
+private:
+    struct Span {
+        const char* name;  // 字符串字面量
+        int64_t start;     // 相对开始时刻的微秒数
+        int64_t duration;
+        size_t peakBytes;  // 阶段内的内存峰值（没有活动内存预算时为0）
+    };
+    
+    std::string name;
+    std::chrono::steady_clock::time_point origin;
+    std::chrono::system_clock::time_point wallClockStart;
+    std::vector<Span> spans;
+    bool finished = false;
+
+public:
+    explicit ConversionTrace(std::string traceName)
+        : name(std::move(traceName)), origin(std::chrono::steady_clock::now()),
+          wallClockStart(std::chrono::system_clock::now()) {
+        spans.reserve(64);
+    }
+    
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+    
+    void add(const char* spanName, int64_t start, int64_t end, size_t peakBytes = 0) {
+        spans.push_back({spanName, start, end - start, peakBytes});
+    }
+    
+    // 按阶段名（首次出现的顺序）累计耗时与最大内存峰值；同名区间多次出现（如分批解析）时注明次数
+    std::string summary(int64_t total) const;
+    
+    // Chrome trace事件格式：每个区间一个完整事件（ph = X），时间单位为微秒
+    bool writeChromeTrace(const std::string& path, int64_t total) const;
+    
+    // 记录汇总日志，并按配置写出trace文件（文件名：<名称>_<日期>_<时间>_<毫秒>.json）
+    void finish();
+};
+
+// 当前线程正在记录的转换（没有时TraceSpan不做任何事）
+inline thread_local ConversionTrace* t_activeTrace = nullptr;
+
+// 在作用域内把trace设为当前线程的活动trace，结束时完成记录
+class TraceScope {
+private:
+    ConversionTrace& trace;
+    ConversionTrace* previous;
+
+public:
+    explicit TraceScope(ConversionTrace& activeTrace) : trace(activeTrace), previous(t_activeTrace) {
+        t_activeTrace = &trace;
+    }
+    
+    ~TraceScope() {
+        t_activeTrace = previous;
+        trace.finish();
+    }
+    
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+// 计时区间：构造时开始，析构或end()时记录到当前线程的活动trace；
+// 有活动内存预算时同时记录阶段内的内存峰值，并作为超出预算时报告的阶段名
+class TraceSpan {
+private:
+    ConversionTrace* trace;
+    MemoryBudget* budget;
+    const char* name;
+    int64_t start;
+    MemoryBudget::StageMark mark = {};
+
+public:
+    explicit TraceSpan(const char* spanName)
+        : trace(t_activeTrace), budget(t_activeBudget), name(spanName), start(trace ? trace->now() : 0) {
+        if (budget) mark = budget->enterStage(name);
+    }
+    
+    ~TraceSpan() {
+        end();
+    }
+    
+    void end() {
+        size_t peakBytes = 0;
+        if (budget) {
+            peakBytes = budget->leaveStage(mark);
+            budget = nullptr;
+        }
+        if (trace) {
+            trace->add(name, start, trace->now(), peakBytes);
+            trace = nullptr;
+        }
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Gaussian clipboard（.frg）与XYZ文本
+Trajectory parseGaussianClipboard(const std::string& filename);
+Trajectory parseGaussianClipboardContent(std::string_view content);
+std::string createXYZString(const Trajectory& trajectory, size_t frame = 0);
+size_t xyzFrameSize(const Trajectory& trajectory, size_t frame);
+char* formatXYZFrame(char* out, const Trajectory& trajectory, size_t frame);
+
+// 帧边界：原子数行之后（注释行起始）的字节位置、原子数行的行号、原子数，
+// 以及实际存在的原子行数（末帧可能被截断）
+struct FrameSpan {
+    size_t begin;
+    size_t countLine;
+    int atomCount;
+    size_t atomLines;
+};
+
+// XYZ解析：逐帧读取、帧边界扫描与并行解析
+void readRemainingXYZFrames(LineCursor& cursor, Trajectory& trajectory, ConversionProgress* progress = nullptr);
+std::vector<FrameSpan> scanXYZFrameSpans(LineCursor& cursor, size_t maxAtoms, bool& finished);
+std::vector<FrameSpan> takeFrameSpans(const std::vector<FrameSpan>& spans, size_t& next, size_t maxAtoms);
+
+// 按帧选择过滤帧下标，atomCount(i)返回第i帧的原子数。autoStride时选择使所选帧原子总数
+// 不超过budgetAtoms的最小步长（单帧已超过预算时只保留第一帧），实际使用的步长写入chosenStride
+template <typename AtomCount>
+std::vector<size_t> selectFrameIndices(size_t frameCount, AtomCount atomCount, const FrameSelection& selection,
+                                       size_t budgetAtoms, size_t& chosenStride) {
+    size_t first = std::min(selection.start, frameCount);
+    size_t last = selection.stop > 0 ? std::min(selection.stop, frameCount) : frameCount;
+    if (last < first) last = first;
+    if (selection.lastN > 0 && last - first > selection.lastN) {
+        first = last - selection.lastN;
+    }
+    
+    size_t stride = selection.stride;
+    if (selection.autoStride && last > first) {
+        const size_t count = last - first;
+        for (stride = 1; stride < count; ++stride) {
+            size_t atoms = 0;
+            for (size_t i = first; i < last && atoms <= budgetAtoms; i += stride) {
+                atoms += atomCount(i);
+            }
+            if (atoms <= budgetAtoms) break;
+        }
+    }
+    chosenStride = std::max<size_t>(stride, 1);
+    
+    std::vector<size_t> selected;
+    selected.reserve((last - first + chosenStride - 1) / chosenStride);
+    for (size_t i = first; i < last; i += chosenStride) {
+        selected.push_back(i);
+    }
+    return selected;
+}
+
+std::vector<FrameSpan> selectFrameSpans(const std::vector<FrameSpan>& spans, const FrameSelection& selection,
+                                        size_t budgetAtoms, size_t& chosenStride);
+void parseXYZFramesParallel(std::string_view content, const std::vector<FrameSpan>& spans,
+                            Trajectory& trajectory, unsigned threads, ConversionProgress* progress = nullptr);
+void readXYZFrames(std::string_view content, LineCursor& cursor, Trajectory& trajectory,
+                   ConversionProgress* progress = nullptr);
+bool parseXYZContent(std::string_view content, Trajectory* trajectory, ConversionProgress* progress = nullptr);
+bool isXYZFormat(std::string_view content);
+Trajectory readMultiXYZ(std::string_view content);
+
+// 输入格式嗅探：只检查内容开头FORMAT_SNIFF_BYTES字节，由已注册的检测器分别给出置信度（0-100），
+// 得分最高且不低于FORMAT_MIN_CONFIDENCE的格式决定使用的解析器（同分时先注册者优先）。
+// 前缀被截断时丢弃末尾不完整的行，truncated告知检测器内容还有后续
+enum class InputFormat {
+    Unknown,
+    StandardXYZ,
+    ExtendedXYZ,
+    SimplifiedXYZ,
+    GaussianClipboard,
+    GaussianLog,
+    BinaryTrajectory
+};
+
+inline constexpr size_t FORMAT_SNIFF_BYTES = 4096;
+inline constexpr int FORMAT_MIN_CONFIDENCE = 50;
+
+using FormatDetector = int (*)(std::string_view prefix, bool truncated);
+
+struct FormatGuess {
+    InputFormat format = InputFormat::Unknown;
+    int confidence = 0;
+};
+
+const char* inputFormatName(InputFormat format);
+void registerFormatDetector(InputFormat format, FormatDetector detector);
+FormatGuess sniffFormat(std::string_view content);
+
+// Gaussian log格式化
+std::string writeGaussianLogHeader();
+size_t gaussianLogGeometrySize(const Trajectory& trajectory, size_t frame,
+                               const std::vector<int>& atomicNumbers, int frameNumber);
+char* formatGaussianLogGeometry(char* out, const Trajectory& trajectory, size_t frame,
+                                const std::vector<int>& atomicNumbers, int frameNumber);
+std::string writeGaussianLogGeometry(const Trajectory& trajectory, size_t frame,
+                                     const std::vector<int>& atomicNumbers, int frameNumber);
+std::string writeGaussianLogFooter();
+std::vector<int> buildAtomicNumberTable(const Trajectory& trajectory);
+size_t formatGaussianLogFrames(const Trajectory& trajectory, int firstFrameNumber, unsigned threads,
+                               const std::function<char*(size_t)>& allocate);
+std::string convertToGaussianLog(const Trajectory& trajectory);
+
+// 临时文件写入器：独占创建文件、按已知大小预分配，并以对齐的大块进行定位写入。
+// 缓冲区大小向上取整为4KB的倍数，除最后一块外每次写入都从块边界开始
+class OutputFileWriter {
+private:
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+    std::vector<char> storage;
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    uint64_t offset;
+    uint64_t preallocated;
+    std::string path;
+    std::chrono::steady_clock::time_point startTime;
+    
+    static constexpr size_t BLOCK_ALIGNMENT = 4096;
+    
+    bool writeBlock(const char* data, size_t size);
+
+public:
+    explicit OutputFileWriter(size_t bufferSize);
+    
+    // 未显式关闭的写入器（转换失败、文件随后被删除）只关闭文件，不记录吞吐量
+    ~OutputFileWriter() {
+        finish(false);
+    }
+    
+    OutputFileWriter(const OutputFileWriter&) = delete;
+    OutputFileWriter& operator=(const OutputFileWriter&) = delete;
+    
+    bool isOpen() const;
+    
+    // 独占创建文件；文件已存在时返回false且alreadyExists为true
+    bool create(const std::string& filepath, bool& alreadyExists);
+    
+    // 按预计输出大小预分配磁盘空间（失败不影响写入）
+    void preallocate(uint64_t size);
+    
+    bool write(const char* data, size_t size);
+    
+    bool write(const std::string& data) {
+        return write(data.data(), data.size());
+    }
+    
+    uint64_t bytesWritten() const {
+        return offset + used;
+    }
+    
+    // 写出剩余数据，截去多余的预分配空间并关闭；成功时记录写入吞吐量
+    bool close() {
+        return finish(true);
+    }
+    
+    // 放弃写入：关闭文件但不记录吞吐量（文件随后被删除）
+    void abandon() {
+        finish(false);
+    }
+    
+private:
+    bool finish(bool report);
+};
+
+// 临时文件：写缓冲区大小、在temp_dir中独占创建不重名的文件、一次写入整个内容
+size_t writeBufferBytes();
+std::string createUniqueTempFile(OutputFileWriter& writer);
+std::string createTempFile(const std::string& content);
+
+// 临时文件回收：单个回收线程按截止时间顺序处理删除任务。
+// 删除失败（文件仍被占用）时按指数退避重试；任务可带就绪检查（如查看器已打开文件），
+// 就绪后经短暂宽限再删除，超过最长等待时间后不再等待就绪。退出时对未完成的任务做最后一次删除
+class TempFileReaper {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ReadyCheck = std::function<bool()>;
+
+private:
+    struct Task {
+        Clock::time_point due;
+        Clock::time_point readyDeadline;  // 等待就绪的最晚时间
+        std::string path;
+        int attempt;
+        ReadyCheck ready;
+    };
+    
+    struct LaterDue {
+        bool operator()(const Task& a, const Task& b) const {
+            return a.due > b.due;
+        }
+    };
+    
+    static constexpr int MAX_ATTEMPTS = 6;
+    static constexpr int READY_POLL_MS = 250;
+    static constexpr int READY_GRACE_MS = 1000;
+    static constexpr int STOP_ATTEMPTS = 3;
+    static constexpr int STOP_RETRY_MS = 100;
+    
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::vector<Task> tasks;  // 按due组织的最小堆
+    std::thread worker;
+    bool stopping = false;
+    
+    void push(Task task) {
+        tasks.push_back(std::move(task));
+        std::push_heap(tasks.begin(), tasks.end(), LaterDue());
+    }
+    
+    Task pop();
+    
+    // 删除文件；返回false表示文件仍然存在，需要重试
+    static bool removeFile(const std::string& path);
+    
+    // 处理一个到期任务；需要再次处理时返回true并更新due
+    bool process(Task& task);
+    
+    void run();
+
+public:
+    ~TempFileReaper() {
+        stop();
+    }
+    
+    void start();
+    
+    // 在delay后删除文件；ready非空时先等待其返回true（最长等待delay），再经宽限时间删除
+    void schedule(const std::string& path, std::chrono::milliseconds delay, ReadyCheck ready = nullptr);
+    
+    // 删除目录中早于maxAge的molecule_*.log（上次运行遗留的临时文件）
+    static size_t sweepStale(const std::string& directory, std::chrono::seconds maxAge);
+    
+    // 停止回收线程，再对尚未完成的任务（包括等待就绪、退避重试中的，以及线程退出前放回的）同步删除：
+    // 仍被占用的文件短暂重试几次，失败的留给下次启动时的sweepStale清理
+    void stop();
+};
+
+// 全局临时文件回收器
+extern TempFileReaper g_reaper;
+
+// 转换结果缓存：键为剪贴板内容与帧选择的哈希，值为temp_dir中的xyzcache_<哈希>.log
+// （或二进制轨迹xyzcache_<哈希>.xyzb）。
+// 按最近使用排序，超出总大小或条目数时淘汰最久未用的文件；启动后首次使用时从目录恢复索引
+class ConversionCache {
+private:
+    struct Entry {
+        uint64_t key;
+        std::string path;
+        uintmax_t bytes;
+    };
+    
+    std::mutex mutex;
+    std::list<Entry> entries;  // 最近使用的在前
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    uintmax_t totalBytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    bool loaded = false;
+    
+    static std::string cachePath(uint64_t key, const char* extension) {
+        char name[40];
+        snprintf(name, sizeof(name), "xyzcache_%016llx%s", static_cast<unsigned long long>(key), extension);
+        return activeConfig().tempDir.empty() ? std::string(name) : activeConfig().tempDir + "/" + name;
+    }
+    
+    // 从temp_dir中已有的缓存文件恢复索引，按修改时间确定最近使用顺序
+    void loadExisting();
+    
+    void evict();
+    
+    std::string rateText() const {
+        size_t total = hits + misses;
+        return "hits: " + std::to_string(hits) + ", misses: " + std::to_string(misses) +
+               ", hit rate: " + std::to_string(total ? hits * 100 / total : 0) + "%";
+    }
+
+public:
+    bool enabled() const {
+        return activeConfig().cacheMaxMB > 0 && activeConfig().cacheMaxEntries > 0;
+    }
+    
+    // 查找缓存的转换结果，命中时返回文件路径并更新最近使用顺序
+    std::string lookup(uint64_t key);
+    
+    // 将新生成的文件移入缓存，返回缓存中的路径；失败时返回空字符串，原文件保持不变
+    std::string insert(uint64_t key, const std::string& file, const char* extension = ".log");
+};
+
+// 全局转换结果缓存
+extern ConversionCache g_conversionCache;
+
+uint64_t conversionCacheKey(std::string_view content, const FrameSelection& selection);
+
+// 二进制轨迹文件（.xyzb）：解析结果的紧凑缓存，读取时内存映射，无需再次解析文本。
+// 布局（本机字节序，即小端）：
+//   文件头32字节：魔数、版本、标志（bit0 = float64坐标）、保留
+//   坐标块：按帧连续存放的x/y/z交错坐标（float32或float64）
+//   元素表：每项为uint16长度 + 原始符号
+//   拓扑表：每项为uint64原子数 + uint32元素ID序列（只在变化时存一份）
+//   帧拓扑下标（uint32）、帧原子偏移表与注释偏移表（uint64，各frameCount + 1项）、注释文本
+//   文件尾88字节：各表的数量与偏移、结束魔数
+// 除坐标块外各段按8字节对齐。文件尾最后写入，因此可以边转换边逐批追加
+inline constexpr char BINARY_TRAJECTORY_MAGIC[8] = {'X', 'Y', 'Z', 'B', '\r', '\n', 0x1A, '\n'};
+inline constexpr char BINARY_TRAJECTORY_END_MAGIC[8] = {'X', 'Y', 'Z', 'B', 'E', 'N', 'D', '\0'};
+inline constexpr uint32_t BINARY_TRAJECTORY_VERSION = 1;
+inline constexpr uint32_t BINARY_TRAJECTORY_FLOAT64 = 1;
+
+struct BinaryTrajectoryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t reserved[2];
+};
+
+struct BinaryTrajectoryTrailer {
+    uint64_t frameCount;
+    uint64_t totalAtoms;
+    uint64_t elementCount;
+    uint64_t topologyCount;
+    uint64_t elementsOffset;
+    uint64_t topologiesOffset;
+    uint64_t frameTopologyOffset;
+    uint64_t frameOffsetsOffset;
+    uint64_t commentOffsetsOffset;
+    uint64_t commentsOffset;
+    char magic[8];
+};
+
+static_assert(sizeof(BinaryTrajectoryHeader) == 32, "unexpected .xyzb header size");
+static_assert(sizeof(BinaryTrajectoryTrailer) == 88, "unexpected .xyzb trailer size");
+
+bool isBinaryTrajectory(std::string_view data);
+
+// 二进制轨迹写入器：逐批追加帧（坐标直接写出，元素、拓扑与帧表留在内存中），finish时写入各表和文件尾。
+// 各批次的元素ID按符号重新映射，拓扑跨批次去重
+class BinaryTrajectoryWriter {
+private:
+    OutputFileWriter file;
+    std::string path;
+    bool doublePrecision;
+    bool failed = false;
+    bool finished = false;
+    std::vector<std::string> elements;
+    std::unordered_map<std::string, uint32_t> elementIds;
+    std::vector<std::vector<uint32_t>> topologies;
+    std::vector<uint32_t> frameTopology;
+    std::vector<uint64_t> frameOffsets = {0};
+    std::vector<uint64_t> commentOffsets = {0};
+    std::string comments;
+    std::vector<char> scratch;
+    
+    bool writeRaw(const void* data, size_t size);
+    
+    template <typename T>
+    bool writeValue(const T& value) {
+        return writeRaw(&value, sizeof(value));
+    }
+    
+    bool pad() {
+        static const char zeros[8] = {};
+        size_t remainder = static_cast<size_t>(file.bytesWritten() % 8);
+        return remainder == 0 || writeRaw(zeros, 8 - remainder);
+    }
+    
+    uint32_t mapElement(const std::string& symbol);
+    
+    template <typename Float>
+    bool writeCoordinates(const Trajectory& batch, size_t begin, size_t end);
+
+public:
+    explicit BinaryTrajectoryWriter(bool useDouble)
+        : file(writeBufferBytes()), doublePrecision(useDouble) {}
+    
+    ~BinaryTrajectoryWriter() {
+        discard();
+    }
+    
+    // 在临时目录中创建文件并写入文件头
+    bool create();
+    
+    const std::string& filePath() const {
+        return path;
+    }
+    
+    bool ok() const {
+        return !path.empty() && !failed && !finished;
+    }
+    
+    size_t frameCount() const {
+        return frameTopology.size();
+    }
+    
+    // 追加一批已解析的帧
+    bool append(const Trajectory& batch);
+    
+    // 写入各表与文件尾并关闭文件；成功后文件归调用方所有
+    bool finish();
+    
+    // 删除未完成的文件
+    void discard();
+};
+
+// 只读内存映射文件
+class MappedFile {
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+    const char* view = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile() {
+        close();
+    }
+    
+    bool open(const std::string& path);
+    
+    void close();
+    
+    const char* data() const {
+        return view;
+    }
+    
+    size_t size() const {
+        return length;
+    }
+};
+
+// 剪贴板文本来源：以借用的只读视图（带显式长度）提供文本，视图在close()前有效。
+// Windows上由剪贴板实现，测试与基准中用MemoryClipboardSource代替
+class ClipboardSource {
+public:
+    virtual ~ClipboardSource() = default;
+    
+    // 打开剪贴板并借用其中的文本；没有文本或失败时返回false（已关闭）
+    virtual bool open() = 0;
+    virtual std::string_view text() const = 0;
+    virtual void close() = 0;
+};
+
+// 剪贴板文本在大小为capacity的分配中的长度（第一个NUL之前，没有NUL时为capacity）
+size_t clipboardTextLength(const char* data, size_t capacity);
+
+// 内存中的剪贴板：借用的视图直接指向保存的文本
+class MemoryClipboardSource : public ClipboardSource {
+private:
+    std::string contents;
+    bool opened = false;
+
+public:
+    MemoryClipboardSource() = default;
+    explicit MemoryClipboardSource(std::string text) : contents(std::move(text)) {}
+    
+    void set(std::string text) {
+        contents = std::move(text);
+    }
+    
+    bool open() override {
+        opened = !contents.empty();
+        return opened;
+    }
+    
+    std::string_view text() const override {
+        return opened ? std::string_view(contents) : std::string_view();
+    }
+    
+    void close() override {
+        opened = false;
+    }
+};
+
+// 一次转换对剪贴板文本的使用：borrow为true时直接借用剪贴板的视图，到release()（或析构）才归还剪贴板；
+// 否则复制一次到调用方的可复用缓冲区后立即归还，剪贴板只占用复制所需的时间
+class ClipboardText {
+private:
+    static constexpr size_t KEEP_BUFFER_BYTES = 64 * 1024 * 1024;  // 更大的复制缓冲区用完即释放
+    
+    ClipboardSource& source;
+    std::string& buffer;
+    std::string_view text;
+    bool held = false;
+    std::chrono::steady_clock::time_point openedAt;
+    
+    void closeSource() {
+        if (!held) return;
+        source.close();
+        held = false;
+        LOG_DEBUGF("Clipboard held for %.1fms", std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - openedAt).count());
+    }
+
+public:
+    ClipboardText(ClipboardSource& clipboard, std::string& copyBuffer) : source(clipboard), buffer(copyBuffer) {}
+    
+    ~ClipboardText() {
+        release();
+    }
+    
+    ClipboardText(const ClipboardText&) = delete;
+    ClipboardText& operator=(const ClipboardText&) = delete;
+    
+    // 读取剪贴板文本；剪贴板中没有文本时返回false
+    bool acquire(bool borrow) {
+        release();
+        openedAt = std::chrono::steady_clock::now();
+        if (!source.open()) return false;
+        held = true;
+        text = source.text();
+        if (!borrow) {
+            try {
+                TraceSpan copySpan("clipboard_copy");
+                buffer.assign(text.data(), text.size());
+            } catch (...) {
+                text = std::string_view();
+                closeSource();
+                throw;
+            }
+            text = buffer;
+            closeSource();
+        }
+        return true;
+    }
+    
+    std::string_view view() const {
+        return text;
+    }
+    
+    // 借用中时把文本复制到缓冲区并立即归还剪贴板（之后的视图指向缓冲区）；已复制时不做任何事
+    std::string_view detach() {
+        if (held) {
+            try {
+                TraceSpan copySpan("clipboard_copy");
+                buffer.assign(text.data(), text.size());
+            } catch (...) {
+                release();
+                throw;
+            }
+            text = buffer;
+            closeSource();
+        }
+        return text;
+    }
+    
+    // 不再需要文本时调用：归还借用的剪贴板，过大的复制缓冲区同时释放
+    void release() {
+        closeSource();
+        text = std::string_view();
+        if (buffer.capacity() > KEEP_BUFFER_BYTES) {
+            std::string().swap(buffer);
+        } else {
+            buffer.clear();
+        }
+    }
+};
+
+// Gaussian clipboard文件的解析结果，文件版本由修改时间和大小标识
+struct ParsedClipboardFile {
+    std::string path;
+    uintmax_t size = 0;
+    std::filesystem::file_time_type modified;
+    Trajectory atoms;
+    std::string xyz;  // 后台预先格式化的XYZ文本（按需解析时为空，写入时直接格式化到剪贴板）
+};
+
+// 工具函数：读取文件大小和修改时间
+bool statFile(const std::string& path, uintmax_t& size, std::filesystem::file_time_type& modified);
+
+// 监视Gaussian clipboard文件：文件变化时在后台重新解析并格式化XYZ文本，
+// 反向热键只需核对修改时间和大小即可直接写入缓存的文本。
+// 监视文件所在目录（Linux使用inotify，Windows使用FindFirstChangeNotification），
+// 变化通知经短暂去抖后再按修改时间和大小判断目标文件是否真的改变
+class ClipboardFileWatcher {
+private:
+    static constexpr int DEBOUNCE_MS = 200;
+    
+    std::mutex mutex;
+    std::shared_ptr<const ParsedClipboardFile> cached;
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> backgroundParses{0};
+#ifdef _WIN32
+    HANDLE stopEvent = NULL;
+#else
+    int wakeFds[2] = {-1, -1};
+#endif
+    
+    void refreshIfChanged(const std::string& file);
+    void run(std::string file);
+
+public:
+    ~ClipboardFileWatcher() {
+        stop();
+    }
+    
+    // 立即解析文件并更新缓存；formatText为true时同时格式化XYZ文本。没有解析到原子时返回nullptr
+    std::shared_ptr<const ParsedClipboardFile> refresh(const std::string& file, bool formatText = true);
+    
+    // 返回与文件当前版本一致的缓存结果，否则返回nullptr
+    std::shared_ptr<const ParsedClipboardFile> current(const std::string& file);
+    
+    // 文件变化触发的后台解析次数
+    size_t parseCount() const {
+        return backgroundParses.load();
+    }
+    
+    void start(const std::string& file);
+    void stop();
+};
+
+// 二进制轨迹读取器：映射文件并校验各表，按帧下标把帧读入Trajectory（可分批读取）
+class BinaryTrajectoryReader {
+private:
+    MappedFile mapped;
+    BinaryTrajectoryTrailer trailer = {};
+    size_t coordinateBytes = 4;
+    std::vector<std::string> elements;
+    std::vector<uint64_t> topologyOffsets;  // 每个拓扑元素ID序列的起始偏移
+    
+    template <typename T>
+    T at(uint64_t offset) const {
+        T value;
+        std::memcpy(&value, mapped.data() + offset, sizeof(T));
+        return value;
+    }
+    
+    uint32_t frameTopology(size_t frame) const {
+        return at<uint32_t>(trailer.frameTopologyOffset + frame * sizeof(uint32_t));
+    }
+    
+    uint64_t frameOffset(size_t frame) const {
+        return at<uint64_t>(trailer.frameOffsetsOffset + frame * sizeof(uint64_t));
+    }
+    
+    uint64_t commentOffset(size_t frame) const {
+        return at<uint64_t>(trailer.commentOffsetsOffset + frame * sizeof(uint64_t));
+    }
+    
+    bool fail(const std::string& path, const std::string& reason) {
+        LOG_ERROR("Invalid binary trajectory " + path + ": " + reason);
+        mapped.close();
+        return false;
+    }
+
+public:
+    bool open(const std::string& path);
+    
+    size_t frameCount() const {
+        return static_cast<size_t>(trailer.frameCount);
+    }
+    
+    size_t totalAtoms() const {
+        return static_cast<size_t>(trailer.totalAtoms);
+    }
+    
+    size_t frameAtomCount(size_t frame) const {
+        return static_cast<size_t>(frameOffset(frame + 1) - frameOffset(frame));
+    }
+    
+    bool doublePrecision() const {
+        return coordinateBytes == 8;
+    }
+    
+    // 把frames中的帧追加到trajectory（元素表按符号合并，拓扑与上一帧相同时复用）
+    void readFrames(const size_t* frames, size_t count, Trajectory& trajectory) const;
+};
+
+// 流式转换每个原子的工作集估算：坐标与元素ID约28字节，格式化后的文本约70字节，留出余量
+inline constexpr size_t STREAM_BYTES_PER_ATOM = 128;
+
+// 流式转换统计
+struct StreamStats {
+    size_t frames = 0;
+    size_t atoms = 0;
+    size_t bytesWritten = 0;
+    size_t peakWorkingSet = 0;
+};
+
+// 流式转换：XYZ文本或二进制轨迹 -> Gaussian log
+bool streamXYZToGaussianLog(std::string_view content, OutputFileWriter& writer,
+                            size_t budgetBytes, StreamStats& stats, ConversionProgress* progress = nullptr,
+                            const std::vector<FrameSpan>* selected = nullptr,
+                            BinaryTrajectoryWriter* capture = nullptr);
+bool streamBinaryTrajectoryToGaussianLog(const BinaryTrajectoryReader& reader, const std::vector<size_t>& frames,
+                                         OutputFileWriter& writer, size_t budgetBytes, StreamStats& stats,
+                                         ConversionProgress* progress = nullptr);
+
+// 完整转换：按格式与配置选择流式或整体转换，写入已创建的writer；失败原因已记录日志。
+// inputParsed在整体解析完成、之后不再读取content时调用（调用方借此提前归还借用的剪贴板）；
+// 流式转换与原样写出的Gaussian log直到写完都读取content，不调用
+bool convertXYZToGaussianLog(std::string_view content, OutputFileWriter& writer, const FrameSelection& selection,
+                             StreamStats& stats, ConversionProgress* progress = nullptr,
+                             BinaryTrajectoryWriter* capture = nullptr,
+                             const std::function<void()>& inputParsed = nullptr);
+bool convertBinaryTrajectoryToGaussianLog(const BinaryTrajectoryReader& reader, OutputFileWriter& writer,
+                                          const FrameSelection& selection, StreamStats& stats,
+                                          ConversionProgress* progress = nullptr);
+bool convertContentToGaussianLog(std::string_view content, InputFormat format, OutputFileWriter& writer,
+                                 const FrameSelection& selection, StreamStats& stats,
+                                 ConversionProgress* progress = nullptr, BinaryTrajectoryWriter* capture = nullptr,
+                                 const std::function<void()>& inputParsed = nullptr);
+// convertContentToGaussianLog是否直到写完都读取content（流式转换或原样写出），不会调用inputParsed
+bool conversionReadsUntilWritten(std::string_view content, InputFormat format);
+
+// 二进制轨迹缓存
+uint64_t binaryCacheKey(std::string_view content);
+std::unique_ptr<BinaryTrajectoryWriter> beginBinaryCapture();
+void commitBinaryCapture(std::unique_ptr<BinaryTrajectoryWriter>& capture, uint64_t key);
+
+// 文件路径模式：剪贴板中是轨迹文件的路径（文本或文件拖放列表）时映射该文件转换，不经剪贴板复制
+bool isBinaryTrajectoryFile(const std::string& path);
+bool isTrajectoryFile(const std::string& path);
+std::string trajectoryPathFromText(std::string_view content);
+std::string trajectoryFileVersion(const std::string& path);
+bool convertTrajectoryFileToGaussianLog(const std::string& path, OutputFileWriter& writer,
+                                        const FrameSelection& selection, StreamStats& stats,
+                                        ConversionProgress* progress = nullptr);
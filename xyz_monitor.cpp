@@ -1,22 +1,6 @@
 #include <windows.h>
 #include <shellapi.h>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <string>
-#include <vector>
-#include <map>
-#include <regex>
-#include <algorithm>
-#include <cctype>
-#include <filesystem>
-#include <ctime>
-#include <iomanip>
-
-// 解决Windows ERROR宏冲突
-#ifdef ERROR
-#undef ERROR
-#endif
+#include "xyz_core.h"
 
 // 资源ID定义
 #define IDI_MAIN_ICON 101
@@ -27,399 +11,29 @@
 #define ID_TRAY_RELOAD 2001
 #define ID_TRAY_EXIT 2002
 #define ID_TRAY_ABOUT 2003
+#define ID_TRAY_CANCEL 2004
+
+// 后台转换状态通知（工作线程 -> 窗口）
+#define WM_CONVERSION_STATE (WM_APP + 1)
+#define ID_PROGRESS_TIMER 3001
 
 // 热键ID
 #define HOTKEY_XYZ_TO_GVIEW 1
 #define HOTKEY_GVIEW_TO_XYZ 2
-
-// 日志级别枚举
-enum class LogLevel {
-    DEBUG = 0,
-    INFO = 1,
-    WARNING = 2,
-    ERROR = 3
-};
-
-// 简化的日志类（无mutex，适用于cross-compilation）
-class Logger {
-private:
-    std::ofstream logFile;
-    LogLevel currentLevel;
-    bool logToConsole;
-    bool logToFile;
-
-public:
-    Logger() : currentLevel(LogLevel::INFO), logToConsole(true), logToFile(true) {}
-    
-    ~Logger() {
-        if (logFile.is_open()) {
-            logFile.close();
-        }
-    }
-    
-    bool initialize(const std::string& logFilePath, LogLevel level = LogLevel::INFO) {
-        currentLevel = level;
-        
-        // 创建日志目录
-        std::filesystem::path logPath(logFilePath);
-        if (logPath.has_parent_path()) {
-            try {
-                std::filesystem::create_directories(logPath.parent_path());
-            } catch (const std::exception& e) {
-                std::cerr << "Failed to create log directory: " << e.what() << std::endl;
-            }
-        }
-        
-        logFile.open(logFilePath, std::ios::app);
-        if (!logFile.is_open()) {
-            std::cerr << "Failed to open log file: " << logFilePath << std::endl;
-            logToFile = false;
-            return false;
-        }
-        
-        // 写入启动分隔符
-        auto now = std::time(nullptr);
-        auto* tm = std::localtime(&now);
-        logFile << "\n========================================\n";
-        logFile << "XYZ Monitor started at: " << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << "\n";
-        logFile << "========================================\n";
-        logFile.flush();
-        
-        return true;
-    }
-    
-    void setLogToConsole(bool enabled) {
-        logToConsole = enabled;
-    }
-    
-    void setLogToFile(bool enabled) {
-        logToFile = enabled;
-    }
-    
-    void setLogLevel(LogLevel level) {
-        currentLevel = level;
-    }
-    
-    void log(LogLevel level, const std::string& message, const std::string& file = "", int line = 0) {
-        if (level < currentLevel) return;
-        
-        // 获取当前时间
-        auto now = std::time(nullptr);
-        auto* tm = std::localtime(&now);
-        
-        // 构建日志消息
-        std::ostringstream oss;
-        oss << "[" << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << "] ";
-        
-        // 添加日志级别
-        switch (level) {
-            case LogLevel::DEBUG:   oss << "[DEBUG] "; break;
-            case LogLevel::INFO:    oss << "[INFO]  "; break;
-            case LogLevel::WARNING: oss << "[WARN]  "; break;
-            case LogLevel::ERROR:   oss << "[ERROR] "; break;
-        }
-        
-        oss << message;
-        
-        // 添加文件和行号信息（用于错误和警告）
-        if (!file.empty() && line > 0 && (level >= LogLevel::WARNING)) {
-            // 只提取文件名，不包含完整路径
-            std::string filename = file;
-            size_t lastSlash = filename.find_last_of("/\\");
-            if (lastSlash != std::string::npos) {
-                filename = filename.substr(lastSlash + 1);
-            }
-            oss << " (" << filename << ":" << line << ")";
-        }
-        
-        std::string logMessage = oss.str();
-        
-        // 输出到控制台
-        if (logToConsole) {
-            if (level >= LogLevel::ERROR) {
-                std::cerr << logMessage << std::endl;
-            } else {
-                std::cout << logMessage << std::endl;
-            }
-        }
-        
-        // 输出到文件
-        if (logToFile && logFile.is_open()) {
-            logFile << logMessage << std::endl;
-            logFile.flush();
-        }
-    }
-};
-
-// 全局日志实例
-Logger g_logger;
-
-// 日志宏定义
-#define LOG_DEBUG(msg) g_logger.log(LogLevel::DEBUG, msg, __FILE__, __LINE__)
-#define LOG_INFO(msg) g_logger.log(LogLevel::INFO, msg)
-#define LOG_WARNING(msg) g_logger.log(LogLevel::WARNING, msg, __FILE__, __LINE__)
-#define LOG_ERROR(msg) g_logger.log(LogLevel::ERROR, msg, __FILE__, __LINE__)
-
-// 配置结构体
-struct Config {
-    std::string hotkey = "CTRL+SHIFT+V";
-    std::string hotkeyReverse = "CTRL+SHIFT+G";  // 新增：反向转换热键
-    std::string gviewPath = "";
-    std::string tempDir = "";
-    std::string logFile = "logs/xyz_monitor.log";
-    std::string gaussianClipboardPath = "";  // 新增：Gaussian clipboard文件路径
-    int waitSeconds = 5;
-    std::string logLevel = "INFO";
-    bool logToConsole = true;
-    bool logToFile = true;
-    // 新增内存配置项
-    int maxMemoryMB = 500;  // 默认500MB
-    size_t maxClipboardChars = 0;  // 自动计算，0表示使用内存计算
-};
-
-// 原子结构体
-struct Atom {
-    std::string symbol;
-    double x, y, z;
-};
-
-// 帧结构体
-struct Frame {
-    std::vector<Atom> atoms;
-    std::string comment;
-};
-
-// 线程参数结构体
-struct DeleteFileThreadParams {
-    std::string filepath;
-    int waitSeconds;
-};
+#define HOTKEY_XYZ_TO_GVIEW_OVERRIDE 3
 
 // 全局变量
-Config g_config;
 HHOOK g_hHook = NULL;
 bool g_running = true;
 NOTIFYICONDATAA g_nid = {};
 HWND g_hwnd = NULL;
 
-// 原子序数映射
-std::map<std::string, int> atomicNumbers = {
-    {"H", 1}, {"He", 2}, {"Li", 3}, {"Be", 4}, {"B", 5}, {"C", 6}, {"N", 7}, {"O", 8}, {"F", 9}, {"Ne", 10},
-    {"Na", 11}, {"Mg", 12}, {"Al", 13}, {"Si", 14}, {"P", 15}, {"S", 16}, {"Cl", 17}, {"Ar", 18}, {"K", 19}, {"Ca", 20},
-    {"Sc", 21}, {"Ti", 22}, {"V", 23}, {"Cr", 24}, {"Mn", 25}, {"Fe", 26}, {"Co", 27}, {"Ni", 28}, {"Cu", 29}, {"Zn", 30},
-    {"Ga", 31}, {"Ge", 32}, {"As", 33}, {"Se", 34}, {"Br", 35}, {"Kr", 36}, {"Rb", 37}, {"Sr", 38}, {"Y", 39}, {"Zr", 40},
-    {"Nb", 41}, {"Mo", 42}, {"Tc", 43}, {"Ru", 44}, {"Rh", 45}, {"Pd", 46}, {"Ag", 47}, {"Cd", 48}, {"In", 49}, {"Sn", 50},
-    {"Sb", 51}, {"Te", 52}, {"I", 53}, {"Xe", 54}, {"Cs", 55}, {"Ba", 56}, {"La", 57}, {"Ce", 58}, {"Pr", 59}, {"Nd", 60},
-    {"Pm", 61}, {"Sm", 62}, {"Eu", 63}, {"Gd", 64}, {"Tb", 65}, {"Dy", 66}, {"Ho", 67}, {"Er", 68}, {"Tm", 69}, {"Yb", 70},
-    {"Lu", 71}, {"Hf", 72}, {"Ta", 73}, {"W", 74}, {"Re", 75}, {"Os", 76}, {"Ir", 77}, {"Pt", 78}, {"Au", 79}, {"Hg", 80},
-    {"Tl", 81}, {"Pb", 82}, {"Bi", 83}, {"Po", 84}, {"At", 85}, {"Rn", 86}, {"Fr", 87}, {"Ra", 88}, {"Ac", 89}, {"Th", 90},
-    {"Pa", 91}, {"U", 92}, {"Np", 93}, {"Pu", 94}, {"Am", 95}, {"Cm", 96}, {"Bk", 97}, {"Cf", 98}, {"Es", 99}, {"Fm", 100},
-    {"Md", 101}, {"No", 102}, {"Lr", 103}, {"Rf", 104}, {"Db", 105}, {"Sg", 106}, {"Bh", 107}, {"Hs", 108}, {"Mt", 109}, {"Ds", 110},
-    {"Rg", 111}, {"Cn", 112}, {"Nh", 113}, {"Fl", 114}, {"Mc", 115}, {"Lv", 116}, {"Ts", 117}, {"Og", 118}
-};
-
-// 新增：原子序数到元素符号的映射
-std::map<int, std::string> atomicNumberToSymbol = {
-    {1, "H"}, {2, "He"}, {3, "Li"}, {4, "Be"}, {5, "B"}, {6, "C"}, {7, "N"}, {8, "O"},
-    {9, "F"}, {10, "Ne"}, {11, "Na"}, {12, "Mg"}, {13, "Al"}, {14, "Si"}, {15, "P"}, {16, "S"},
-    {17, "Cl"}, {18, "Ar"}, {19, "K"}, {20, "Ca"}, {21, "Sc"}, {22, "Ti"}, {23, "V"}, {24, "Cr"},
-    {25, "Mn"}, {26, "Fe"}, {27, "Co"}, {28, "Ni"}, {29, "Cu"}, {30, "Zn"}, {31, "Ga"}, {32, "Ge"},
-    {33, "As"}, {34, "Se"}, {35, "Br"}, {36, "Kr"}, {37, "Rb"}, {38, "Sr"}, {39, "Y"}, {40, "Zr"},
-    {41, "Nb"}, {42, "Mo"}, {43, "Tc"}, {44, "Ru"}, {45, "Rh"}, {46, "Pd"}, {47, "Ag"}, {48, "Cd"},
-    {49, "In"}, {50, "Sn"}, {51, "Sb"}, {52, "Te"}, {53, "I"}, {54, "Xe"}, {55, "Cs"}, {56, "Ba"},
-    {57, "La"}, {58, "Ce"}, {59, "Pr"}, {60, "Nd"}, {61, "Pm"}, {62, "Sm"}, {63, "Eu"}, {64, "Gd"},
-    {65, "Tb"}, {66, "Dy"}, {67, "Ho"}, {68, "Er"}, {69, "Tm"}, {70, "Yb"}, {71, "Lu"}, {72, "Hf"},
-    {73, "Ta"}, {74, "W"}, {75, "Re"}, {76, "Os"}, {77, "Ir"}, {78, "Pt"}, {79, "Au"}, {80, "Hg"},
-    {81, "Tl"}, {82, "Pb"}, {83, "Bi"}, {84, "Po"}, {85, "At"}, {86, "Rn"}
-};
-
 // 前置声明
 bool reloadConfiguration();
 void cleanupTrayIcon();
 
-size_t calculateMaxChars(int memoryMB) {
-    const int BYTES_PER_CHAR = 8;
-    size_t totalBytes = static_cast<size_t>(memoryMB) * 1024 * 1024;
-    size_t maxChars = totalBytes / BYTES_PER_CHAR;
-    
-    const size_t MIN_CHARS = 10000;      // 最少1万字符
-    const size_t MAX_CHARS = 100000000;  // 最多1亿字符
-    
-    if (maxChars < MIN_CHARS) maxChars = MIN_CHARS;
-    if (maxChars > MAX_CHARS) maxChars = MAX_CHARS;
-    
-    return maxChars;
-}
-
-// 工具函数：字符串修整
-std::string trim(const std::string& str) {
-    size_t first = str.find_first_not_of(' ');
-    if (std::string::npos == first) {
-        return str;
-    }
-    size_t last = str.find_last_not_of(' ');
-    return str.substr(first, (last - first + 1));
-}
-
-// 工具函数：字符串分割
-std::vector<std::string> split(const std::string& str, char delim) {
-    std::vector<std::string> tokens;
-    std::stringstream ss(str);
-    std::string token;
-    while (std::getline(ss, token, delim)) {
-        std::string trimmed = trim(token);
-        if (!trimmed.empty()) {
-            tokens.push_back(trimmed);
-        }
-    }
-    return tokens;
-}
-
-// 工具函数：字符串分割（多个分隔符）
-std::vector<std::string> splitWhitespace(const std::string& str) {
-    std::vector<std::string> tokens;
-    std::istringstream iss(str);
-    std::string token;
-    while (iss >> token) {
-        tokens.push_back(token);
-    }
-    return tokens;
-}
-
-// 字符串转日志级别
-LogLevel stringToLogLevel(const std::string& levelStr) {
-    std::string upper = levelStr;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-    
-    if (upper == "DEBUG") return LogLevel::DEBUG;
-    if (upper == "INFO") return LogLevel::INFO;
-    if (upper == "WARNING" || upper == "WARN") return LogLevel::WARNING;
-    if (upper == "ERROR") return LogLevel::ERROR;
-    
-    return LogLevel::INFO; // 默认
-}
-
-// 获取原子序数
-int getAtomicNumber(const std::string& symbol) {
-    std::string processed = symbol;
-    processed = trim(processed);
-    
-    if (!processed.empty()) {
-        processed[0] = std::toupper(processed[0]);
-        for (size_t i = 1; i < processed.length(); ++i) {
-            processed[i] = std::tolower(processed[i]);
-        }
-    }
-    
-    auto it = atomicNumbers.find(processed);
-    return (it != atomicNumbers.end()) ? it->second : 0;
-}
-
-// 延时删除文件的线程函数
-DWORD WINAPI DeleteFileThread(LPVOID lpParam) {
-    DeleteFileThreadParams* params = static_cast<DeleteFileThreadParams*>(lpParam);
-    
-    try {
-        Sleep(params->waitSeconds * 1000);
-        
-        if (DeleteFileA(params->filepath.c_str())) {
-            // 成功删除
-        } else {
-            DWORD error = GetLastError();
-            std::cerr << "Failed to delete temporary file: " << params->filepath << " (Error: " << error << ")" << std::endl;
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Exception in delete file thread: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown exception in delete file thread" << std::endl;
-    }
-    
-    delete params;
-    return 0;
-}
-
-// 读取配置文件
-bool loadConfig(const std::string& configFile) {
-    std::ifstream file(configFile);
-    if (!file.is_open()) {
-        // 创建默认配置文件
-        std::ofstream outFile(configFile);
-        if (outFile.is_open()) {
-            outFile << "hotkey=CTRL+SHIFT+V\n";
-            outFile << "hotkey_reverse=CTRL+SHIFT+G\n";
-            outFile << "gview_path=gview.exe\n";
-            outFile << "gaussian_clipboard_path=Clipboard.frg\n";
-            outFile << "temp_dir=temp\n";
-            outFile << "log_file=logs/xyz_monitor.log\n";
-            outFile << "log_level=INFO\n";
-            outFile << "log_to_console=true\n";
-            outFile << "log_to_file=true\n";
-            outFile << "wait_seconds=5\n";
-            outFile << "# Memory limit in MB for processing (default: 500MB)\n";
-            outFile << "max_memory_mb=500\n";
-            outFile << "# Optional: set explicit character limit (0 = auto calculate from memory)\n";
-            outFile << "max_clipboard_chars=0\n";
-            outFile.close();
-            std::cout << "Created default config file: " << configFile << std::endl;
-        } else {
-            std::cerr << "Failed to create default config file: " << configFile << std::endl;
-        }
-        return false;
-    }
-    
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;
-        
-        size_t pos = line.find('=');
-        if (pos != std::string::npos) {
-            std::string key = trim(line.substr(0, pos));
-            std::string value = trim(line.substr(pos + 1));
-            
-            try {
-                if (key == "hotkey") {
-                    g_config.hotkey = value;
-                } else if (key == "hotkey_reverse") {
-                    g_config.hotkeyReverse = value;
-                } else if (key == "gview_path") {
-                    g_config.gviewPath = value;
-                } else if (key == "gaussian_clipboard_path") {
-                    g_config.gaussianClipboardPath = value;
-                } else if (key == "temp_dir") {
-                    g_config.tempDir = value;
-                } else if (key == "log_file") {
-                    g_config.logFile = value;
-                } else if (key == "log_level") {
-                    g_config.logLevel = value;
-                } else if (key == "log_to_console") {
-                    g_config.logToConsole = (value == "true" || value == "1");
-                } else if (key == "log_to_file") {
-                    g_config.logToFile = (value == "true" || value == "1");
-                } else if (key == "wait_seconds") {
-                    g_config.waitSeconds = std::stoi(value);
-                } else if (key == "max_memory_mb") {
-                    g_config.maxMemoryMB = std::stoi(value);
-                    if (g_config.maxMemoryMB < 50) {
-                        LOG_WARNING("max_memory_mb is too small (" + std::to_string(g_config.maxMemoryMB) + "), setting to 50MB");
-                        g_config.maxMemoryMB = 50;
-                    }
-                } else if (key == "max_clipboard_chars") {
-                    size_t charLimit = std::stoull(value);
-                    g_config.maxClipboardChars = charLimit;
-                }
-            } catch (const std::exception& e) {
-                LOG_ERROR("Error parsing config value for key '" + key + "': " + std::string(e.what()));
-            }
-        }
-    }
-    file.close();
-    
-    if (g_config.maxClipboardChars == 0) {
-        g_config.maxClipboardChars = calculateMaxChars(g_config.maxMemoryMB);
-    }
-    
-    return true;
-}
+// 全局转换任务队列
+ConversionJobQueue g_jobQueue;
 
 // 解析热键字符串
 bool parseHotkey(const std::string& hotkeyStr, UINT& modifiers, UINT& vk) {
@@ -486,6 +100,7 @@ bool reregisterHotkeys() {
         // 先注销旧热键
         UnregisterHotKey(g_hwnd, HOTKEY_XYZ_TO_GVIEW);
         UnregisterHotKey(g_hwnd, HOTKEY_GVIEW_TO_XYZ);
+        UnregisterHotKey(g_hwnd, HOTKEY_XYZ_TO_GVIEW_OVERRIDE);
         
         // 注册主热键（XYZ到GView）
         UINT modifiers, vk;
@@ -510,11 +125,33 @@ bool reregisterHotkeys() {
             }
         }
         
+        // 注册覆盖帧选择的热键（可留空不注册）
+        if (!g_config.hotkeyOverride.empty() && parseHotkey(g_config.hotkeyOverride, modifiers, vk)) {
+            if (RegisterHotKey(g_hwnd, HOTKEY_XYZ_TO_GVIEW_OVERRIDE, modifiers, vk)) {
+                LOG_INFO("Override hotkey registered: " + g_config.hotkeyOverride);
+            } else {
+                DWORD error = GetLastError();
+                LOG_ERROR("Failed to register override hotkey: " + g_config.hotkeyOverride + " (Error: " + std::to_string(error) + ")");
+            }
+        }
+        
         return true;
     }
     return false;
 }
 
+// 按配置启动或停止Gaussian clipboard文件监视
+void restartClipboardWatcher();
+
+// 按配置启动或停止异步日志
+void applyAsyncLogging() {
+    if (g_config.logAsync) {
+        g_logger.startAsync(g_config.logBlockWhenFull);
+    } else {
+        g_logger.shutdown();
+    }
+}
+
 // 重新加载配置
 bool reloadConfiguration() {
     LOG_INFO("Reloading configuration...");
@@ -522,6 +159,9 @@ bool reloadConfiguration() {
     try {
         std::string oldHotkey = g_config.hotkey;
         std::string oldHotkeyReverse = g_config.hotkeyReverse;
+        std::string oldHotkeyOverride = g_config.hotkeyOverride;
+        std::string oldClipboardPath = g_config.gaussianClipboardPath;
+        bool oldWatchClipboard = g_config.watchGaussianClipboard;
         std::string oldLogLevel = g_config.logLevel;
         bool oldLogToConsole = g_config.logToConsole;
         bool oldLogToFile = g_config.logToFile;
@@ -548,13 +188,21 @@ bool reloadConfiguration() {
             LOG_INFO("File logging changed to: " + std::string(g_config.logToFile ? "enabled" : "disabled"));
         }
         
+        applyAsyncLogging();
+        
         // 如果热键改变了，重新注册
-        if (oldHotkey != g_config.hotkey || oldHotkeyReverse != g_config.hotkeyReverse) {
+        if (oldHotkey != g_config.hotkey || oldHotkeyReverse != g_config.hotkeyReverse ||
+            oldHotkeyOverride != g_config.hotkeyOverride) {
             if (reregisterHotkeys()) {
                 LOG_INFO("Hotkeys re-registered successfully");
             }
         }
         
+        // Gaussian clipboard路径或监视开关改变时重启监视
+        if (oldClipboardPath != g_config.gaussianClipboardPath || oldWatchClipboard != g_config.watchGaussianClipboard) {
+            restartClipboardWatcher();
+        }
+        
         LOG_INFO("Configuration reloaded successfully");
         return true;
     } catch (const std::exception& e) {
@@ -598,6 +246,8 @@ void showTrayMenu(HWND hwnd, POINT pt) {
     if (hMenu) {
         AppendMenuA(hMenu, MF_STRING, ID_TRAY_ABOUT, "XYZ Monitor v1.1 - by Bane Dysta");
         AppendMenuA(hMenu, MF_SEPARATOR, 0, NULL);
+        UINT cancelFlags = g_jobQueue.status().busy ? MF_STRING : (MF_STRING | MF_GRAYED);
+        AppendMenuA(hMenu, cancelFlags, ID_TRAY_CANCEL, "Cancel Current Conversion");
         AppendMenuA(hMenu, MF_STRING, ID_TRAY_RELOAD, "Reload Configuration");
         AppendMenuA(hMenu, MF_SEPARATOR, 0, NULL);
         AppendMenuA(hMenu, MF_STRING, ID_TRAY_EXIT, "Exit");
@@ -627,6 +277,10 @@ void showAboutDialog(HWND hwnd) {
     message += "Current Settings:\n";
     message += "XYZ->GView: " + g_config.hotkey + "\n";
     message += "GView->XYZ: " + g_config.hotkeyReverse + "\n";
+    message += "Frames: " + g_config.frameSelection.describe() + "\n";
+    if (!g_config.hotkeyOverride.empty()) {
+        message += "Override (" + g_config.hotkeyOverride + "): " + g_config.overrideSelection.describe() + "\n";
+    }
     message += "GView Path: " + (g_config.gviewPath.empty() ? "Not configured" : g_config.gviewPath) + "\n";
     message += "Gaussian Clipboard: " + (g_config.gaussianClipboardPath.empty() ? "Not configured" : g_config.gaussianClipboardPath) + "\n";
     message += "Log Level: " + g_config.logLevel + "\n\n";
@@ -638,43 +292,104 @@ void showAboutDialog(HWND hwnd) {
     MessageBoxA(hwnd, message.c_str(), "About XYZ Monitor", MB_OK | MB_ICONINFORMATION);
 }
 
-// 读取剪贴板内容
-std::string getClipboardText() {
-    try {
+// Windows剪贴板的CF_TEXT：打开剪贴板并锁定数据，借用期间其他程序无法访问剪贴板
+class Win32ClipboardSource : public ClipboardSource {
+private:
+    HANDLE data = NULL;
+    const char* locked = nullptr;
+    size_t length = 0;
+    bool opened = false;
+
+public:
+    ~Win32ClipboardSource() override {
+        close();
+    }
+    
+    bool open() override {
+        close();
         if (!OpenClipboard(NULL)) {
             DWORD error = GetLastError();
             LOG_ERROR("Failed to open clipboard (Error: " + std::to_string(error) + ")");
-            return "";
+            return false;
         }
+        opened = true;
         
-        HANDLE hData = GetClipboardData(CF_TEXT);
-        if (hData == NULL) {
-            CloseClipboard();
+        data = GetClipboardData(CF_TEXT);
+        if (data == NULL) {
             LOG_DEBUG("No text data in clipboard");
-            return "";
+            close();
+            return false;
         }
-        
-        char* pszText = static_cast<char*>(GlobalLock(hData));
-        if (pszText == NULL) {
-            CloseClipboard();
+        locked = static_cast<const char*>(GlobalLock(data));
+        if (locked == NULL) {
             LOG_ERROR("Failed to lock clipboard data");
+            close();
+            return false;
+        }
+        
+        // GlobalSize是分配大小（可能大于文本），只在其末尾查找结束符，不扫描整个文本
+        length = clipboardTextLength(locked, GlobalSize(data));
+        LOG_DEBUG("Clipboard text length: " + std::to_string(length));
+        return length > 0;
+    }
+    
+    std::string_view text() const override {
+        return std::string_view(locked, length);
+    }
+    
+    void close() override {
+        if (locked) GlobalUnlock(data);
+        if (opened) CloseClipboard();
+        data = NULL;
+        locked = nullptr;
+        length = 0;
+        opened = false;
+    }
+};
+
+// 读取剪贴板中的文件拖放列表（在资源管理器中复制的文件）：返回第一个轨迹文件的路径，没有时返回空字符串
+std::string getClipboardDropPath() {
+    try {
+        if (!IsClipboardFormatAvailable(CF_HDROP)) {
+            return "";
+        }
+        if (!OpenClipboard(NULL)) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to open clipboard (Error: " + std::to_string(error) + ")");
             return "";
         }
         
-        std::string text(pszText);
-        GlobalUnlock(hData);
+        std::vector<std::string> files;
+        HDROP drop = static_cast<HDROP>(GetClipboardData(CF_HDROP));
+        if (drop != NULL) {
+            UINT count = DragQueryFileA(drop, 0xFFFFFFFF, NULL, 0);
+            for (UINT i = 0; i < count; ++i) {
+                UINT length = DragQueryFileA(drop, i, NULL, 0);
+                std::string file(length + 1, '\0');
+                file.resize(DragQueryFileA(drop, i, &file[0], length + 1));
+                files.push_back(file);
+            }
+        }
         CloseClipboard();
         
-        LOG_DEBUG("Clipboard text length: " + std::to_string(text.length()));
-        return text;
+        for (const std::string& file : files) {
+            if (isTrajectoryFile(file)) {
+                LOG_DEBUG("Clipboard file list names trajectory " + file);
+                return file;
+            }
+        }
+        if (!files.empty()) {
+            LOG_DEBUG("Clipboard file list has no .xyz or .xyzb file");
+        }
+        return "";
     } catch (const std::exception& e) {
-        LOG_ERROR("Exception reading clipboard: " + std::string(e.what()));
+        LOG_ERROR("Exception reading clipboard file list: " + std::string(e.what()));
         return "";
     }
 }
 
-// 新增：写入剪贴板
-bool writeToClipboard(const std::string& text) {
+// 写入剪贴板：按精确长度分配剪贴板内存，由fill把文本（不含结尾的NUL）直接写入其中
+bool writeToClipboard(size_t length, const std::function<void(char*)>& fill) {
     try {
         if (!OpenClipboard(NULL)) {
             LOG_ERROR("Cannot open clipboard for writing");
@@ -683,7 +398,7 @@ bool writeToClipboard(const std::string& text) {
         
         EmptyClipboard();
         
-        HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, text.length() + 1);
+        HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, length + 1);
         if (hMem == NULL) {
             LOG_ERROR("Cannot allocate memory for clipboard");
             CloseClipboard();
@@ -698,7 +413,8 @@ bool writeToClipboard(const std::string& text) {
             return false;
         }
         
-        strcpy_s(pMem, text.length() + 1, text.c_str());
+        fill(pMem);
+        pMem[length] = '\0';
         GlobalUnlock(hMem);
         
         if (SetClipboardData(CF_TEXT, hMem) == NULL) {
@@ -716,511 +432,284 @@ bool writeToClipboard(const std::string& text) {
     }
 }
 
-// 新增：解析Gaussian clipboard文件
-std::vector<Atom> parseGaussianClipboard(const std::string& filename) {
-    std::vector<Atom> atoms;
-    
+bool writeToClipboard(const std::string& text) {
+    return writeToClipboard(text.size(), [&](char* out) { std::memcpy(out, text.data(), text.size()); });
+}
+
+// 使用GView打开文件；scheduleDelete为true时在wait_seconds后删除该文件
+bool openWithGView(const std::string& filepath, bool scheduleDelete = true) {
     try {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            LOG_ERROR("Cannot open Gaussian clipboard file: " + filename);
-            return atoms;
+        if (activeConfig().gviewPath.empty()) {
+            LOG_ERROR("GView path not configured!");
+            return false;
         }
         
-        std::string line;
+        std::string command = "\"" + activeConfig().gviewPath + "\" \"" + filepath + "\"";
+        LOG_DEBUG("Executing command: " + command);
         
-        // 跳过第一行（头部）
-        if (!std::getline(file, line)) {
-            LOG_ERROR("Empty file or cannot read header");
-            return atoms;
-        }
+        STARTUPINFOA si;
+        PROCESS_INFORMATION pi;
+        ZeroMemory(&si, sizeof(si));
+        si.cb = sizeof(si);
+        ZeroMemory(&pi, sizeof(pi));
         
-        // 读取原子数量
-        if (!std::getline(file, line)) {
-            LOG_ERROR("Cannot read number of atoms");
-            return atoms;
+        if (!CreateProcessA(NULL, const_cast<char*>(command.c_str()), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to launch GView (Error: " + std::to_string(error) + ")");
+            return false;
         }
         
-        int numAtoms;
-        try {
-            numAtoms = std::stoi(line);
-            LOG_DEBUG("Expected number of atoms: " + std::to_string(numAtoms));
-        } catch (const std::exception& e) {
-            LOG_ERROR("Cannot parse number of atoms: " + line);
-            return atoms;
-        }
+        CloseHandle(pi.hThread);
         
-        // 读取原子数据
-        for (int i = 0; i < numAtoms; i++) {
-            if (!std::getline(file, line)) {
-                LOG_WARNING("Expected " + std::to_string(numAtoms) + " atoms, but only found " + std::to_string(i));
-                break;
-            }
-            
-            std::istringstream iss(line);
-            int atomicNumber;
-            double x, y, z;
-            std::string label;
-            
-            if (iss >> atomicNumber >> x >> y >> z) {
-                // 可选的标签
-                iss >> label;
-                
-                auto it = atomicNumberToSymbol.find(atomicNumber);
-                if (it != atomicNumberToSymbol.end()) {
-                    Atom atom;
-                    atom.symbol = it->second;
-                    atom.x = x;
-                    atom.y = y;
-                    atom.z = z;
-                    atoms.push_back(atom);
-                    
-                    LOG_DEBUG("Added atom " + std::to_string(i + 1) + ": " + atom.symbol + 
-                             " (" + std::to_string(atomicNumber) + ") at (" + 
-                             std::to_string(atom.x) + ", " + std::to_string(atom.y) + ", " + std::to_string(atom.z) + ")");
-                } else {
-                    LOG_WARNING("Unknown atomic number " + std::to_string(atomicNumber) + " in line: " + line);
-                }
+        if (scheduleDelete) {
+            std::chrono::milliseconds delay(static_cast<long long>(activeConfig().waitSeconds) * 1000);
+            if (activeConfig().deleteWhenOpened) {
+                // 查看器进入空闲（已完成启动并读入文件）或已退出后删除，最长等待wait_seconds
+                std::shared_ptr<void> process(pi.hProcess, [](void* handle) { CloseHandle(handle); });
+                g_reaper.schedule(filepath, delay, [process]() {
+                    return WaitForInputIdle(process.get(), 0) == 0 ||
+                           WaitForSingleObject(process.get(), 0) == WAIT_OBJECT_0;
+                });
             } else {
-                LOG_WARNING("Cannot parse atom data in line: " + line);
+                CloseHandle(pi.hProcess);
+                g_reaper.schedule(filepath, delay);
             }
+        } else {
+            CloseHandle(pi.hProcess);
         }
         
-        file.close();
-        LOG_INFO("Parsed " + std::to_string(atoms.size()) + " atoms from Gaussian clipboard");
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception parsing Gaussian clipboard: " + std::string(e.what()));
-    }
-    
-    return atoms;
-}
-
-// 新增：创建XYZ字符串
-std::string createXYZString(const std::vector<Atom>& atoms) {
-    try {
-        std::ostringstream oss;
-        
-        oss << atoms.size() << std::endl;
-        oss << "Converted from Gaussian clipboard" << std::endl;
-        
-        for (const auto& atom : atoms) {
-            oss << std::left << std::setw(2) << atom.symbol 
-                << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << atom.x
-                << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << atom.y
-                << " " << std::right << std::setw(12) << std::fixed << std::setprecision(6) << atom.z
-                << std::endl;
-        }
-        
-        return oss.str();
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception creating XYZ string: " + std::string(e.what()));
-        return "";
-    }
-}
-
-// 检查是否为有效的坐标行
-bool isValidCoordinateLine(const std::string& line) {
-    std::vector<std::string> parts = splitWhitespace(line);
-    if (parts.size() < 4) return false;
-    
-    try {
-        double x = std::stod(parts[1]);
-        double y = std::stod(parts[2]);
-        double z = std::stod(parts[3]);
-        (void)x; (void)y; (void)z;
+        LOG_INFO("Launched GView successfully");
         return true;
-    } catch (const std::exception&) {
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception launching GView: " + std::string(e.what()));
         return false;
     }
 }
 
-// 检查是否为简化XYZ格式
-bool isSimplifiedXYZFormat(const std::vector<std::string>& lines) {
-    if (lines.empty()) return false;
-    
-    size_t maxCheck = std::min(static_cast<size_t>(5), lines.size());
-    for (size_t i = 0; i < maxCheck; ++i) {
-        if (!isValidCoordinateLine(lines[i])) {
-            return false;
+// 打开转换生成的临时文件：缓存启用时先移入缓存（之后由缓存负责删除），
+// 否则按wait_seconds延迟删除
+void openConversionResult(const std::string& tempFile, uint64_t cacheKey) {
+    std::string file = tempFile;
+    bool cached = false;
+    if (g_conversionCache.enabled()) {
+        TraceSpan insertSpan("cache_insert");
+        std::string cachedPath = g_conversionCache.insert(cacheKey, tempFile);
+        if (!cachedPath.empty()) {
+            file = cachedPath;
+            cached = true;
         }
     }
     
-    return true;
-}
-
-// 检查是否为XYZ格式
-bool isXYZFormat(const std::string& content) {
-    try {
-        if (content.empty()) {
-            LOG_DEBUG("Content is empty");
-            return false;
-        }
-        
-        if (content.find('\0') != std::string::npos) {
-            LOG_DEBUG("Content contains binary data");
-            return false;
-        }
-        
-        std::vector<std::string> lines = split(content, '\n');
-        if (lines.empty()) {
-            LOG_DEBUG("No lines found in content");
-            return false;
-        }
-        
-        // 检查是否是标准XYZ格式（第一行是原子数）
-        try {
-            int atomCount = std::stoi(lines[0]);
-            if (atomCount > 0 && atomCount <= 10000) {
-                if (lines.size() < static_cast<size_t>(atomCount + 2)) {
-                    LOG_DEBUG("Not enough lines for atom count: " + std::to_string(atomCount));
-                    return false;
-                }
-                
-                size_t maxCheck = std::min(static_cast<size_t>(5), static_cast<size_t>(atomCount));
-                for (size_t i = 0; i < maxCheck; ++i) {
-                    if (i + 2 < lines.size()) {
-                        if (!isValidCoordinateLine(lines[i + 2])) {
-                            LOG_DEBUG("Invalid coordinate line at index: " + std::to_string(i + 2));
-                            return false;
-                        }
-                    }
-                }
-                LOG_DEBUG("Detected standard XYZ format");
-                return true;
-            }
-        } catch (const std::exception&) {
-            LOG_DEBUG("First line is not atom count, checking simplified format");
-        }
-        
-        bool isSimplified = isSimplifiedXYZFormat(lines);
-        if (isSimplified) {
-            LOG_DEBUG("Detected simplified XYZ format");
-        } else {
-            LOG_DEBUG("Not recognized as XYZ format");
+    TraceSpan launchSpan("viewer_launch");
+    if (openWithGView(file, !cached)) {
+        LOG_INFO("Opened with GView successfully.");
+    } else {
+        LOG_ERROR("Failed to open with GView.");
+        if (!cached && !DeleteFileA(file.c_str())) {
+            LOG_ERROR("Failed to cleanup temp file: " + file);
         }
-        return isSimplified;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in isXYZFormat: " + std::string(e.what()));
-        return false;
     }
 }
 
-// 读取单帧XYZ数据
-bool readXYZFrame(const std::vector<std::string>& lines, size_t startLine, Frame& frame, size_t& nextStart) {
-    if (startLine >= lines.size()) return false;
-    
-    try {
-        int numAtoms = std::stoi(lines[startLine]);
-        if (numAtoms <= 0) return false;
-        
-        frame.comment = (startLine + 1 < lines.size()) ? lines[startLine + 1] : "";
-        frame.atoms.clear();
-        
-        for (int i = 0; i < numAtoms; ++i) {
-            size_t lineIndex = startLine + 2 + static_cast<size_t>(i);
-            if (lineIndex >= lines.size()) break;
-            
-            std::vector<std::string> parts = splitWhitespace(lines[lineIndex]);
-            if (parts.size() >= 4) {
-                try {
-                    Atom atom;
-                    atom.symbol = parts[0];
-                    atom.x = std::stod(parts[1]);
-                    atom.y = std::stod(parts[2]);
-                    atom.z = std::stod(parts[3]);
-                    frame.atoms.push_back(atom);
-                } catch (const std::exception& e) {
-                    LOG_WARNING("Failed to parse atom at line " + std::to_string(lineIndex) + ": " + std::string(e.what()));
-                    continue;
-                }
-            }
-        }
-        
-        nextStart = startLine + static_cast<size_t>(numAtoms) + 2;
-        return !frame.atoms.empty();
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in readXYZFrame: " + std::string(e.what()));
+// 从二进制轨迹转换：映射文件，按帧选择取帧并流式写出，然后打开结果。
+// 只有文件无法打开或校验失败时返回false（调用方可改为解析文本）
+bool convertBinaryTrajectory(const std::string& path, const FrameSelection& selection, uint64_t cacheKey,
+                             ConversionProgress* progress) {
+    BinaryTrajectoryReader reader;
+    TraceSpan openSpan("binary_open");
+    if (!reader.open(path)) {
         return false;
     }
-}
-
-// 读取多帧XYZ数据
-std::vector<Frame> readMultiXYZ(const std::string& content) {
-    std::vector<Frame> frames;
+    openSpan.end();
+    LOG_INFO("Loaded binary trajectory " + path + " (" + std::to_string(reader.frameCount()) + " frames, " +
+             std::to_string(reader.totalAtoms()) + " atoms, " + (reader.doublePrecision() ? "float64" : "float32") + ")");
     
-    try {
-        std::vector<std::string> lines = split(content, '\n');
-        
-        if (lines.empty()) {
-            LOG_DEBUG("No lines to process");
-            return frames;
-        }
-        
-        try {
-            std::stoi(lines[0]);
-            // 标准格式
-            LOG_DEBUG("Processing standard XYZ format");
-            size_t lineIndex = 0;
-            while (lineIndex < lines.size()) {
-                Frame frame;
-                size_t nextStart;
-                if (readXYZFrame(lines, lineIndex, frame, nextStart)) {
-                    frames.push_back(frame);
-                    lineIndex = nextStart;
-                } else {
-                    LOG_WARNING("Failed to read frame starting at line: " + std::to_string(lineIndex));
-                    break;
-                }
-            }
-        } catch (const std::exception&) {
-            // 简化格式：直接处理坐标行
-            LOG_DEBUG("Processing simplified XYZ format");
-            Frame frame;
-            frame.comment = "Simplified XYZ format";
-            
-            for (const std::string& line : lines) {
-                std::vector<std::string> parts = splitWhitespace(line);
-                if (parts.size() >= 4) {
-                    try {
-                        Atom atom;
-                        atom.symbol = parts[0];
-                        atom.x = std::stod(parts[1]);
-                        atom.y = std::stod(parts[2]);
-                        atom.z = std::stod(parts[3]);
-                        frame.atoms.push_back(atom);
-                    } catch (const std::exception& e) {
-                        LOG_WARNING("Failed to parse simplified format line: " + std::string(e.what()));
-                        continue;
-                    }
-                }
-            }
-            
-            if (!frame.atoms.empty()) {
-                frames.push_back(frame);
-            }
-        }
-        
-        LOG_INFO("Processed " + std::to_string(frames.size()) + " frames");
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in readMultiXYZ: " + std::string(e.what()));
+    OutputFileWriter writer(writeBufferBytes());
+    TraceSpan createSpan("temp_file_create");
+    std::string tempFile = createUniqueTempFile(writer);
+    createSpan.end();
+    if (tempFile.empty()) {
+        LOG_ERROR("Failed to create temporary file.");
+        return true;
     }
     
-    return frames;
-}
-
-// 写入Gaussian LOG头部
-std::string writeGaussianLogHeader() {
-    return " ! This file was generated by XYZ Monitor\n"
-           " \n"
-           " 0 basis functions\n"
-           " 0 alpha electrons\n"
-           " 0 beta electrons\n"
-           "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
-}
-
-// 写入Gaussian LOG几何结构部分
-std::string writeGaussianLogGeometry(const Frame& frame, int frameNumber) {
-    std::ostringstream oss;
-    
-    oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
-    oss << " \n";
-    oss << "                         Standard orientation:\n";
-    oss << " ---------------------------------------------------------------------\n";
-    oss << " Center     Atomic      Atomic             Coordinates (Angstroms)\n";
-    oss << " Number     Number       Type             X           Y           Z\n";
-    oss << " ---------------------------------------------------------------------\n";
-    
-    for (size_t i = 0; i < frame.atoms.size(); ++i) {
-        const Atom& atom = frame.atoms[i];
-        int atomicNum = getAtomicNumber(atom.symbol);
-        
-        oss << "      " << (i + 1) << "          " << atomicNum 
-            << "           0        " << std::fixed << std::setprecision(6)
-            << std::setw(10) << atom.x << "    "
-            << std::setw(10) << atom.y << "    "
-            << std::setw(10) << atom.z << "\n";
+    StreamStats stats;
+    if (!convertBinaryTrajectoryToGaussianLog(reader, writer, selection, stats, progress)) {
+        if (isCancelled(progress)) {
+            LOG_INFO("Conversion cancelled.");
+        }
+        writer.abandon();
+        std::error_code ec;
+        std::filesystem::remove(tempFile, ec);
+        return true;
     }
     
-    oss << " ---------------------------------------------------------------------\n";
-    oss << " \n";
-    oss << " SCF Done:      -100.000000000\n";
-    oss << " \n";
-    oss << "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n";
-    oss << " Step number   " << frameNumber << "\n";
-    oss << "         Item               Value     Threshold  Converged?\n";
-    oss << " Maximum Force            1.000000     1.000000     NO\n";
-    oss << " RMS     Force            1.000000     1.000000     NO\n";
-    oss << " Maximum Displacement     1.000000     1.000000     NO\n";
-    oss << " RMS     Displacement     1.000000     1.000000     NO\n";
-    
-    return oss.str();
-}
-
-// 写入Gaussian LOG尾部
-std::string writeGaussianLogFooter() {
-    return "GradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGradGrad\n"
-           " Normal termination of Gaussian\n";
+    openConversionResult(tempFile, cacheKey);
+    return true;
 }
 
-// 转换为Gaussian LOG格式
-std::string convertToGaussianLog(const std::vector<Frame>& frames) {
-    if (frames.empty()) {
-        LOG_ERROR("No frames to convert");
-        return "";
+// 文件路径模式：映射剪贴板中路径指向的轨迹文件并转换，然后打开结果
+void convertTrajectoryFile(const std::string& path, const FrameSelection& selection, uint64_t cacheKey,
+                           ConversionProgress* progress) {
+    OutputFileWriter writer(writeBufferBytes());
+    TraceSpan createSpan("temp_file_create");
+    std::string tempFile = createUniqueTempFile(writer);
+    createSpan.end();
+    if (tempFile.empty()) {
+        LOG_ERROR("Failed to create temporary file.");
+        return;
     }
     
-    try {
-        std::ostringstream oss;
-        
-        oss << writeGaussianLogHeader();
-        
-        for (size_t i = 0; i < frames.size(); ++i) {
-            oss << writeGaussianLogGeometry(frames[i], static_cast<int>(i + 1));
-        }
-        
-        oss << writeGaussianLogFooter();
-        
-        LOG_DEBUG("Converted " + std::to_string(frames.size()) + " frames to Gaussian log format");
-        return oss.str();
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in convertToGaussianLog: " + std::string(e.what()));
-        return "";
-    }
-}
-
-// 创建临时文件
-std::string createTempFile(const std::string& content) {
-    try {
-        if (!g_config.tempDir.empty()) {
-            std::filesystem::create_directories(g_config.tempDir);
-        }
-        
-        std::time_t t = std::time(nullptr);
-        std::ostringstream filename;
-        filename << "molecule_" << t << ".log";
-        
-        std::string filepath = g_config.tempDir.empty() ? filename.str() : g_config.tempDir + "/" + filename.str();
-        
-        std::ofstream file(filepath);
-        if (!file.is_open()) {
-            LOG_ERROR("Failed to create temp file: " + filepath);
-            return "";
-        }
-        
-        file << content;
-        file.close();
-        
-        LOG_INFO("Created temporary file: " + filepath);
-        return filepath;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception creating temp file: " + std::string(e.what()));
-        return "";
-    }
-}
-
-// 使用GView打开文件
-bool openWithGView(const std::string& filepath) {
-    try {
-        if (g_config.gviewPath.empty()) {
-            LOG_ERROR("GView path not configured!");
-            return false;
-        }
-        
-        std::string command = "\"" + g_config.gviewPath + "\" \"" + filepath + "\"";
-        LOG_DEBUG("Executing command: " + command);
-        
-        STARTUPINFOA si;
-        PROCESS_INFORMATION pi;
-        ZeroMemory(&si, sizeof(si));
-        si.cb = sizeof(si);
-        ZeroMemory(&pi, sizeof(pi));
-        
-        if (!CreateProcessA(NULL, const_cast<char*>(command.c_str()), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-            DWORD error = GetLastError();
-            LOG_ERROR("Failed to launch GView (Error: " + std::to_string(error) + ")");
-            return false;
-        }
-        
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        
-        DeleteFileThreadParams* params = new DeleteFileThreadParams;
-        params->filepath = filepath;
-        params->waitSeconds = g_config.waitSeconds;
-        
-        HANDLE hThread = CreateThread(NULL, 0, DeleteFileThread, params, 0, NULL);
-        if (hThread) {
-            CloseHandle(hThread);
+    StreamStats stats;
+    if (!convertTrajectoryFileToGaussianLog(path, writer, selection, stats, progress)) {
+        if (isCancelled(progress)) {
+            LOG_INFO("Conversion cancelled.");
         } else {
-            DWORD error = GetLastError();
-            LOG_ERROR("Failed to create delete thread (Error: " + std::to_string(error) + ")");
-            delete params;
+            LOG_ERROR("Failed to convert trajectory file: " + path);
         }
-        
-        LOG_INFO("Launched GView successfully");
-        return true;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception launching GView: " + std::string(e.what()));
-        return false;
+        writer.abandon();
+        std::error_code ec;
+        std::filesystem::remove(tempFile, ec);
+        return;
     }
+    
+    openConversionResult(tempFile, cacheKey);
 }
 
-// 处理剪贴板内容（XYZ到GView）
-void processClipboardXYZToGView() {
+// 处理剪贴板内容（XYZ到GView），多帧标准XYZ只转换selection选中的帧
+void processClipboardXYZToGView(const FrameSelection& selection, ConversionProgress* progress = nullptr) {
     LOG_INFO("Processing clipboard (XYZ to GView)...");
+    ConversionTrace trace("xyz_to_gview");
+    TraceScope traceScope(trace);
+    MemoryBudget budget(conversionMemoryLimit());
+    MemoryBudgetScope memoryScope(budget, "xyz_to_gview");
     
     try {
-        std::string content = getClipboardText();
-        if (content.empty()) {
+        // 剪贴板中是轨迹文件（复制的文件或文本路径）时不读取其内容，之后映射该文件转换。
+        // 文本按clipboard_borrow借用，或复制到在转换之间复用的缓冲区（只由任务线程使用）。
+        // 只有整体转换借用到解析完成；流式转换与原样写出直到写完都读取文本，开始前先复制出来归还剪贴板
+        static std::string clipboardBuffer;
+        Win32ClipboardSource clipboard;
+        ClipboardText clipboardText(clipboard, clipboardBuffer);
+        std::string_view content;
+        TraceSpan readSpan("clipboard_read");
+        std::string filePath = getClipboardDropPath();
+        if (filePath.empty() && clipboardText.acquire(activeConfig().clipboardBorrow)) {
+            content = clipboardText.view();
+            filePath = trajectoryPathFromText(content);
+            if (!filePath.empty()) {
+                clipboardText.release();
+                content = std::string_view();
+            }
+        }
+        readSpan.end();
+        if (filePath.empty() && content.empty()) {
             LOG_INFO("Clipboard is empty or not text format.");
             return;
         }
         
-        if (content.length() > g_config.maxClipboardChars) {
-            LOG_WARNING("Clipboard content is too large (" + std::to_string(content.length()) + 
-                       " characters). Limit is " + std::to_string(g_config.maxClipboardChars) + 
-                       " characters (" + std::to_string(g_config.maxMemoryMB) + "MB memory limit).");
-            return;
+        // 缓存键取路径与文件版本（大小和修改时间）；文本先按开头部分嗅探格式，
+        // 误复制的普通文本在哈希整个内容之前即被拒绝
+        std::string fileVersion;
+        FormatGuess guess;
+        if (!filePath.empty()) {
+            fileVersion = trajectoryFileVersion(filePath);
+        } else {
+            TraceSpan sniffSpan("format_sniff");
+            guess = sniffFormat(content);
+            sniffSpan.end();
+            if (guess.format == InputFormat::Unknown) {
+                LOG_INFO("Clipboard text is not a recognized molecular format.");
+                return;
+            }
+            LOG_INFO(std::string("Detected ") + inputFormatName(guess.format) + " (confidence " +
+                     std::to_string(guess.confidence) + ")");
+        }
+        
+        // 相同内容与帧选择已转换过时直接打开缓存的结果
+        uint64_t cacheKey = 0;
+        if (g_conversionCache.enabled()) {
+            TraceSpan lookupSpan("cache_lookup");
+            cacheKey = conversionCacheKey(filePath.empty() ? content : fileVersion, selection);
+            std::string cachedFile = g_conversionCache.lookup(cacheKey);
+            lookupSpan.end();
+            if (!cachedFile.empty()) {
+                TraceSpan launchSpan("viewer_launch");
+                if (openWithGView(cachedFile, false)) {
+                    LOG_INFO("Opened cached conversion with GView successfully.");
+                } else {
+                    LOG_ERROR("Failed to open with GView.");
+                }
+                return;
+            }
         }
         
-        if (!isXYZFormat(content)) {
-            LOG_INFO("Invalid XYZ format in clipboard.");
+        if (!filePath.empty()) {
+            LOG_INFO("Converting trajectory file " + filePath);
+            convertTrajectoryFile(filePath, selection, cacheKey, progress);
             return;
         }
         
-        double estimatedMemoryMB = (content.length() * 8.0) / (1024.0 * 1024.0);
-        LOG_INFO("Processing " + std::to_string(content.length()) + " characters (estimated " + 
-                std::to_string(static_cast<int>(estimatedMemoryMB)) + "MB memory usage)");
-        
-        std::vector<Frame> frames = readMultiXYZ(content);
-        if (frames.empty()) {
-            LOG_ERROR("Failed to parse XYZ data.");
-            return;
+        // 同一XYZ内容解析过时缓存中有其二进制轨迹，从中转换而不再解析文本
+        bool xyzFormat = guess.format == InputFormat::StandardXYZ || guess.format == InputFormat::ExtendedXYZ ||
+                         guess.format == InputFormat::SimplifiedXYZ;
+        uint64_t binaryKey = 0;
+        if (xyzFormat && g_conversionCache.enabled() && activeConfig().binaryCacheBytes > 0) {
+            TraceSpan lookupSpan("cache_lookup");
+            binaryKey = binaryCacheKey(content);
+            std::string binaryFile = g_conversionCache.lookup(binaryKey);
+            lookupSpan.end();
+            if (!binaryFile.empty() && convertBinaryTrajectory(binaryFile, selection, cacheKey, progress)) {
+                return;
+            }
         }
         
-        LOG_INFO("Found " + std::to_string(frames.size()) + " frame(s) with " + std::to_string(frames[0].atoms.size()) + " atoms.");
-        
-        std::string gaussianContent = convertToGaussianLog(frames);
-        if (gaussianContent.empty()) {
-            LOG_ERROR("Failed to convert to Gaussian log format.");
+        // 内存由转换预算实测并限制，这里只检查显式配置的字符数上限
+        if (activeConfig().maxClipboardChars > 0 && content.length() > activeConfig().maxClipboardChars) {
+            LOG_WARNING("Clipboard content is too large (" + std::to_string(content.length()) + 
+                       " characters). Limit is " + std::to_string(activeConfig().maxClipboardChars) + 
+                       " characters (max_clipboard_chars).");
             return;
         }
         
-        std::string tempFile = createTempFile(gaussianContent);
+        // 完整转换时顺带写出二进制轨迹（有帧选择时只解析部分帧，不写）
+        TraceSpan createSpan("temp_file_create");
+        std::unique_ptr<BinaryTrajectoryWriter> capture;
+        if (!selection.active() && binaryKey != 0) {
+            capture = beginBinaryCapture();
+        }
         
+        OutputFileWriter writer(writeBufferBytes());
+        std::string tempFile = createUniqueTempFile(writer);
+        createSpan.end();
         if (tempFile.empty()) {
             LOG_ERROR("Failed to create temporary file.");
             return;
         }
         
-        if (openWithGView(tempFile)) {
-            LOG_INFO("Opened with GView successfully.");
-        } else {
-            LOG_ERROR("Failed to open with GView.");
-            if (!DeleteFileA(tempFile.c_str())) {
-                LOG_ERROR("Failed to cleanup temp file: " + tempFile);
+        if (conversionReadsUntilWritten(content, guess.format)) {
+            content = clipboardText.detach();
+        }
+        
+        StreamStats stats;
+        bool converted = convertContentToGaussianLog(content, guess.format, writer, selection, stats, progress,
+                                                     capture.get(), [&]() { clipboardText.release(); });
+        clipboardText.release();
+        if (!converted) {
+            if (isCancelled(progress)) {
+                LOG_INFO("Conversion cancelled.");
             }
+            writer.abandon();
+            std::error_code ec;
+            std::filesystem::remove(tempFile, ec);
+            return;
         }
+        LOG_INFO("Created temporary file: " + tempFile);
+        
+        TraceSpan commitSpan("binary_capture");
+        commitBinaryCapture(capture, binaryKey);
+        commitSpan.end();
+        openConversionResult(tempFile, cacheKey);
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in processClipboardXYZToGView: " + std::string(e.what()));
     } catch (...) {
@@ -1228,39 +717,64 @@ void processClipboardXYZToGView() {
     }
 }
 
+// 全局Gaussian clipboard文件监视器
+ClipboardFileWatcher g_clipboardWatcher;
+
+void restartClipboardWatcher() {
+    if (g_config.watchGaussianClipboard) {
+        g_clipboardWatcher.start(g_config.gaussianClipboardPath);
+    } else {
+        g_clipboardWatcher.stop();
+    }
+}
+
 // 新增：处理GView clipboard到XYZ
-void processGViewClipboardToXYZ() {
+void processGViewClipboardToXYZ(ConversionProgress* progress = nullptr) {
     LOG_INFO("Processing GView clipboard to XYZ...");
+    ConversionTrace trace("gview_to_xyz");
+    TraceScope traceScope(trace);
+    MemoryBudget budget(conversionMemoryLimit());
+    MemoryBudgetScope memoryScope(budget, "gview_to_xyz");
     
     try {
-        if (g_config.gaussianClipboardPath.empty()) {
+        if (activeConfig().gaussianClipboardPath.empty()) {
             LOG_ERROR("Gaussian clipboard path not configured!");
             return;
         }
         
-        // 解析Gaussian clipboard文件
-        std::vector<Atom> atoms = parseGaussianClipboard(g_config.gaussianClipboardPath);
+        // 文件未变化时直接使用后台预解析的结果，否则现在解析
+        TraceSpan lookupSpan("preparsed_lookup");
+        std::shared_ptr<const ParsedClipboardFile> parsed = g_clipboardWatcher.current(activeConfig().gaussianClipboardPath);
+        lookupSpan.end();
+        if (parsed) {
+            LOG_INFO("Using pre-parsed Gaussian clipboard (" + std::to_string(parsed->atoms.totalAtoms()) + " atoms)");
+        } else {
+            parsed = g_clipboardWatcher.refresh(activeConfig().gaussianClipboardPath, false);
+        }
         
-        if (atoms.empty()) {
+        if (!parsed) {
             LOG_ERROR("No atoms found in Gaussian clipboard file");
             LOG_INFO("Make sure you have copied a molecule in Gaussian and the path is correct.");
             return;
         }
         
-        LOG_INFO("SUCCESS: Parsed " + std::to_string(atoms.size()) + " atoms");
-        
-        // 创建XYZ字符串
-        std::string xyzString = createXYZString(atoms);
-        
-        if (xyzString.empty()) {
-            LOG_ERROR("Failed to create XYZ string");
+        LOG_INFO("SUCCESS: Parsed " + std::to_string(parsed->atoms.totalAtoms()) + " atoms");
+        if (progress) progress->framesParsed.store(1);
+        if (isCancelled(progress)) {
+            LOG_INFO("Conversion cancelled.");
             return;
         }
         
-        // 写入剪贴板
-        if (writeToClipboard(xyzString)) {
+        // 写入剪贴板：有后台预先格式化的文本时复制它，否则按精确大小直接格式化到剪贴板内存中
+        TraceSpan writeSpan("clipboard_write");
+        const Trajectory& atoms = parsed->atoms;
+        bool written = parsed->xyz.empty()
+            ? writeToClipboard(xyzFrameSize(atoms, 0), [&](char* out) { formatXYZFrame(out, atoms, 0); })
+            : writeToClipboard(parsed->xyz);
+        writeSpan.end();
+        if (written) {
+            if (progress) progress->framesWritten.store(1);
             LOG_INFO("SUCCESS: XYZ data written to clipboard!");
-            LOG_DEBUG("XYZ content preview (first 200 chars): " + xyzString.substr(0, 200) + "...");
         } else {
             LOG_ERROR("Failed to write to clipboard");
         }
@@ -1271,15 +785,77 @@ void processGViewClipboardToXYZ() {
     }
 }
 
+// 启动后台转换工作线程
+void startConversionWorker() {
+    g_jobQueue.start(
+        [](ConversionDirection direction, ConversionProgress& progress) {
+            if (direction == ConversionDirection::XYZToGView) {
+                processClipboardXYZToGView(activeConfig().frameSelection, &progress);
+            } else if (direction == ConversionDirection::XYZToGViewOverride) {
+                processClipboardXYZToGView(activeConfig().overrideSelection, &progress);
+            } else {
+                processGViewClipboardToXYZ(&progress);
+            }
+        },
+        []() {
+            if (g_hwnd) PostMessageA(g_hwnd, WM_CONVERSION_STATE, 0, 0);
+        });
+}
+
+// 按当前任务状态更新托盘提示
+void updateTrayTooltip() {
+    if (g_nid.cbSize == 0) return;
+    
+    ConversionJobQueue::Status status = g_jobQueue.status();
+    std::string tip = "XYZ Monitor - XYZ<->GView Bridge";
+    if (status.busy) {
+        tip = std::string(status.direction == ConversionDirection::GViewToXYZ ? "GView->XYZ" : "XYZ->GView") +
+              ": " + std::to_string(status.framesParsed) + " parsed, " +
+              std::to_string(status.framesWritten) + " written";
+        if (status.queued > 0) {
+            tip += " (+" + std::to_string(status.queued) + " queued)";
+        }
+    }
+    
+    strncpy_s(g_nid.szTip, sizeof(g_nid.szTip), tip.c_str(), sizeof(g_nid.szTip) - 1);
+    g_nid.uFlags = NIF_TIP;
+    Shell_NotifyIconA(NIM_MODIFY, &g_nid);
+}
+
+// 提交热键对应的转换任务
+void submitConversion(ConversionDirection direction) {
+    if (!g_jobQueue.submit(direction)) {
+        LOG_INFO("Conversion already queued, ignoring repeated hotkey press");
+    }
+}
+
 // 窗口过程
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     try {
         switch (uMsg) {
             case WM_HOTKEY:
                 if (wParam == HOTKEY_XYZ_TO_GVIEW) {
-                    processClipboardXYZToGView();
+                    submitConversion(ConversionDirection::XYZToGView);
                 } else if (wParam == HOTKEY_GVIEW_TO_XYZ) {
-                    processGViewClipboardToXYZ();
+                    submitConversion(ConversionDirection::GViewToXYZ);
+                } else if (wParam == HOTKEY_XYZ_TO_GVIEW_OVERRIDE) {
+                    submitConversion(ConversionDirection::XYZToGViewOverride);
+                }
+                return 0;
+                
+            case WM_CONVERSION_STATE:
+                // 有任务时定时刷新进度，空闲时恢复默认提示
+                if (g_jobQueue.status().busy) {
+                    SetTimer(hwnd, ID_PROGRESS_TIMER, 500, NULL);
+                } else {
+                    KillTimer(hwnd, ID_PROGRESS_TIMER);
+                }
+                updateTrayTooltip();
+                return 0;
+                
+            case WM_TIMER:
+                if (wParam == ID_PROGRESS_TIMER) {
+                    updateTrayTooltip();
                 }
                 return 0;
                 
@@ -1303,6 +879,12 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                         showAboutDialog(hwnd);
                         break;
                         
+                    case ID_TRAY_CANCEL:
+                        if (g_jobQueue.cancelCurrent()) {
+                            LOG_INFO("Cancellation requested for current conversion");
+                        }
+                        break;
+                        
                     case ID_TRAY_RELOAD:
                         if (reloadConfiguration()) {
                             MessageBoxA(hwnd, "Configuration reloaded successfully!", "XYZ Monitor", MB_OK | MB_ICONINFORMATION);
@@ -1342,6 +924,12 @@ int main() {
         
         g_logger.setLogToConsole(g_config.logToConsole);
         g_logger.setLogToFile(g_config.logToFile);
+        applyAsyncLogging();
+        // 异常终止前写出缓冲区中的日志
+        std::set_terminate([]() {
+            g_logger.flush();
+            std::abort();
+        });
         
         LOG_INFO("XYZ Monitor v1.1 starting...");
         
@@ -1349,13 +937,28 @@ int main() {
         LOG_INFO("  XYZ->GView Hotkey: " + g_config.hotkey);
         LOG_INFO("  GView->XYZ Hotkey: " + g_config.hotkeyReverse);
         LOG_INFO("  GView Path: " + g_config.gviewPath);
-        LOG_INFO("  Gaussian Clipboard: " + g_config.gaussianClipboardPath);
+        LOG_INFO("  Gaussian Clipboard: " + g_config.gaussianClipboardPath +
+                 (g_config.watchGaussianClipboard ? " (watched)" : ""));
         LOG_INFO("  Temp Dir: " + g_config.tempDir);
         LOG_INFO("  Log File: " + g_config.logFile);
-        LOG_INFO("  Log Level: " + g_config.logLevel);
-        LOG_INFO("  Wait Seconds: " + std::to_string(g_config.waitSeconds));
-        LOG_INFO("  Max Memory: " + std::to_string(g_config.maxMemoryMB) + "MB");
-        LOG_INFO("  Max Characters: " + std::to_string(g_config.maxClipboardChars));
+        LOG_INFO("  Log Level: " + g_config.logLevel + (g_config.logAsync ?
+                 (g_config.logBlockWhenFull ? " (async, block when full)" : " (async, drop when full)") : ""));
+        LOG_INFO("  Wait Seconds: " + std::to_string(g_config.waitSeconds) +
+                 (g_config.deleteWhenOpened ? " (delete once opened)" : ""));
+        LOG_INFO("  Max Memory: " + std::to_string(g_config.maxMemoryMB) + "MB per conversion");
+        LOG_INFO("  Max Characters: " + (g_config.maxClipboardChars == 0 ? std::string("unlimited") : std::to_string(g_config.maxClipboardChars)));
+        LOG_INFO("  Clipboard Text: " + std::string(g_config.clipboardBorrow ? "borrowed until parsed (copied for streamed conversions)" : "copied once"));
+        LOG_INFO("  Stream Conversion: " + std::string(g_config.streamConversion ? "enabled" : "disabled"));
+        LOG_INFO("  Frame Selection: " + g_config.frameSelection.describe());
+        LOG_INFO("  Override Hotkey: " + (g_config.hotkeyOverride.empty() ? std::string("disabled") :
+                 g_config.hotkeyOverride + " (" + g_config.overrideSelection.describe() + ")"));
+        LOG_INFO("  Conversion Cache: " + (g_config.cacheMaxMB > 0 && g_config.cacheMaxEntries > 0 ?
+                 std::to_string(g_config.cacheMaxEntries) + " entries, " + std::to_string(g_config.cacheMaxMB) + "MB" :
+                 std::string("disabled")));
+        LOG_INFO("  Binary Cache: " + (g_config.binaryCacheBytes == 0 ? std::string("disabled") :
+                 std::string(g_config.binaryCacheBytes == 8 ? "float64" : "float32")));
+        LOG_INFO("  Worker Threads: " + (g_config.workerThreads == 0 ? std::string("auto") : std::to_string(g_config.workerThreads)));
+        LOG_INFO("  Conversion Traces: " + (g_config.traceConversions ? g_config.traceDir : std::string("disabled")));
         
         // 创建隐藏窗口
         WNDCLASSA wc = {};
@@ -1392,6 +995,16 @@ int main() {
             return 1;
         }
         
+        // 临时文件回收线程；先清理上次运行遗留的临时文件
+        g_reaper.start();
+        TempFileReaper::sweepStale(g_config.tempDir, std::chrono::seconds(std::max(g_config.waitSeconds, 60)));
+        
+        // 后台预解析Gaussian clipboard文件
+        restartClipboardWatcher();
+        
+        // 转换在后台线程执行，热键处理不阻塞消息循环
+        startConversionWorker();
+        
         LOG_INFO("XYZ Monitor is running. Check system tray for options.");
         LOG_INFO("Press " + g_config.hotkey + " to convert clipboard XYZ to GView.");
         LOG_INFO("Press " + g_config.hotkeyReverse + " to convert GView clipboard to XYZ.");
@@ -1404,12 +1017,17 @@ int main() {
         }
         
         // 清理
+        g_jobQueue.stop();
+        g_reaper.stop();
+        g_clipboardWatcher.stop();
         UnregisterHotKey(g_hwnd, HOTKEY_XYZ_TO_GVIEW);
         UnregisterHotKey(g_hwnd, HOTKEY_GVIEW_TO_XYZ);
+        UnregisterHotKey(g_hwnd, HOTKEY_XYZ_TO_GVIEW_OVERRIDE);
         cleanupTrayIcon();
         DestroyWindow(g_hwnd);
         
         LOG_INFO("XYZ Monitor stopped.");
+        g_logger.shutdown();
         return 0;
     } catch (const std::exception& e) {
         LOG_ERROR("Fatal exception in main: " + std::string(e.what()));
@@ -1418,4 +1036,4 @@ int main() {
         LOG_ERROR("Fatal unknown exception in main");
         return 1;
     }
-}
\ No newline at end of file
+}
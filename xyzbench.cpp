@@ -0,0 +1,710 @@
+// xyzbench - 核心转换阶段的微基准：确定性地生成合成XYZ/.frg输入，测量各阶段的吞吐量（MB/s、atoms/s）、
+// 分配次数、峰值堆内存与峰值RSS，并输出可在两次运行之间比较的JSON结果（Linux）
+#include "xyz_core.h"
+
+#include <cmath>
+#include <map>
+#include <new>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+// ===== 峰值RSS：/proc/self/clear_refs写入5会把VmHWM重置为当前RSS，从而按阶段测量 =====
+
+long readProcStatusKB(const char* key) {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t keyLength = std::strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, keyLength, key) == 0 && line.size() > keyLength && line[keyLength] == ':') {
+            return std::strtol(line.c_str() + keyLength + 1, nullptr, 10);
+        }
+    }
+#else
+    (void)key;
+#endif
+    return 0;
+}
+
+bool resetPeakRss() {
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (!clearRefs) return false;
+    clearRefs << "5";
+    clearRefs.flush();
+    return static_cast<bool>(clearRefs);
+#else
+    return false;
+#endif
+}
+
+long peakRssKB() {
+    long peak = readProcStatusKB("VmHWM");
+#ifdef __linux__
+    if (peak == 0) {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) peak = usage.ru_maxrss;
+    }
+#endif
+    return peak;
+}
+
+// ===== 确定性合成输入生成器 =====
+
+// xorshift64*：相同种子在任何平台上生成相同的输入
+class SyntheticRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit SyntheticRandom(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    // [0, 1)
+    double uniform() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// 有机/金属有机体系中常见的元素分布（含双字母符号，覆盖元素查找表的两条路径）
+struct ElementWeight {
+    const char* symbol;
+    int weight;
+};
+
+constexpr ElementWeight SYNTHETIC_ELEMENTS[] = {
+    {"H", 40}, {"C", 30}, {"O", 10}, {"N", 8}, {"S", 3}, {"Cl", 3}, {"P", 2}, {"Fe", 2}, {"Br", 1}, {"Zn", 1},
+};
+
+const char* pickElement(SyntheticRandom& random) {
+    int total = 0;
+    for (const ElementWeight& element : SYNTHETIC_ELEMENTS) total += element.weight;
+    int value = static_cast<int>(random.next() % static_cast<uint64_t>(total));
+    for (const ElementWeight& element : SYNTHETIC_ELEMENTS) {
+        if (value < element.weight) return element.symbol;
+        value -= element.weight;
+    }
+    return "C";
+}
+
+struct BenchCase {
+    std::string name;
+    size_t atoms = 0;
+    size_t frames = 1;
+    bool crlf = false;
+    bool simplified = false;   // 只有"元素 x y z"行，没有原子数与注释行（单帧）
+    bool frg = false;          // Gaussian clipboard文件（原子序数 x y z）
+};
+
+// 每个原子的元素与初始坐标；各帧在此基础上加小幅扰动（类似MD轨迹）
+struct SyntheticTopology {
+    std::vector<const char*> symbols;
+    std::vector<double> positions;
+};
+
+SyntheticTopology generateTopology(size_t atoms, SyntheticRandom& random) {
+    SyntheticTopology topology;
+    topology.symbols.reserve(atoms);
+    topology.positions.reserve(atoms * 3);
+    double box = std::cbrt(static_cast<double>(atoms)) * 1.5;
+    for (size_t i = 0; i < atoms; ++i) {
+        topology.symbols.push_back(pickElement(random));
+        for (int axis = 0; axis < 3; ++axis) {
+            topology.positions.push_back((random.uniform() - 0.5) * box);
+        }
+    }
+    return topology;
+}
+
+std::string generateXYZ(const BenchCase& benchCase, uint64_t seed) {
+    SyntheticRandom random(seed);
+    SyntheticTopology topology = generateTopology(benchCase.atoms, random);
+    const char* newline = benchCase.crlf ? "\r\n" : "\n";
+
+    std::string out;
+    out.reserve(benchCase.atoms * benchCase.frames * 52 + benchCase.frames * 32);
+    char line[128];
+    for (size_t frame = 0; frame < benchCase.frames; ++frame) {
+        if (!benchCase.simplified) {
+            out += std::to_string(benchCase.atoms);
+            out += newline;
+            out += "synthetic frame ";
+            out += std::to_string(frame);
+            out += newline;
+        }
+        for (size_t i = 0; i < benchCase.atoms; ++i) {
+            const double* p = &topology.positions[i * 3];
+            int length = std::snprintf(line, sizeof(line), "%-2s %14.8f %14.8f %14.8f%s", topology.symbols[i],
+                                       p[0] + (random.uniform() - 0.5) * 0.1, p[1] + (random.uniform() - 0.5) * 0.1,
+                                       p[2] + (random.uniform() - 0.5) * 0.1, newline);
+            out.append(line, static_cast<size_t>(length));
+        }
+    }
+    return out;
+}
+
+std::string generateFrg(const BenchCase& benchCase, uint64_t seed) {
+    SyntheticRandom random(seed);
+    SyntheticTopology topology = generateTopology(benchCase.atoms, random);
+    const char* newline = benchCase.crlf ? "\r\n" : "\n";
+
+    std::string out = std::string(" synthetic Gaussian clipboard") + newline + std::to_string(benchCase.atoms) + newline;
+    out.reserve(out.size() + benchCase.atoms * 48);
+    char line[128];
+    for (size_t i = 0; i < benchCase.atoms; ++i) {
+        const double* p = &topology.positions[i * 3];
+        int length = std::snprintf(line, sizeof(line), " %d %14.8f %14.8f %14.8f%s",
+                                   getAtomicNumber(topology.symbols[i]), p[0], p[1], p[2], newline);
+        out.append(line, static_cast<size_t>(length));
+    }
+    return out;
+}
+
+// ===== 阶段计时 =====
+
+struct BenchOptions {
+    bool quick = false;
+    double minSeconds = 0.5;
+    uint64_t seed = 1;
+    int threads = 0;
+    std::string filter;
+    std::string jsonFile;
+    bool customCase = false;
+    BenchCase custom;
+};
+
+struct StageResult {
+    std::string caseName;
+    std::string stage;
+    size_t atoms = 0;          // 每次迭代处理的原子数（原子-帧）
+    size_t frames = 0;
+    uint64_t inputBytes = 0;   // 每次迭代处理的字节数
+    size_t iterations = 0;
+    double bestSeconds = 0;
+    double medianSeconds = 0;
+    double allocations = 0;    // 每次迭代
+    double allocatedBytes = 0;
+    long peakRssKB = 0;
+    long peakRssDeltaKB = 0;   // 峰值RSS相对阶段开始时RSS的增量
+    long peakHeapKB = 0;       // 预热迭代中由核心库分配记账测得的峰值堆内存
+    double bytesPerAtomFrame = 0;
+};
+
+// 防止结果被优化掉
+static volatile size_t g_sink = 0;
+
+// 先预热一次（同时测量峰值RSS与峰值堆内存），再重复计时直到累计minSeconds且至少3次；
+// 分配次数取计时迭代的平均值。分配统计使用不限额的内存预算
+template <typename Fn>
+StageResult runStage(const BenchOptions& options, const BenchCase& benchCase, const std::string& stage,
+                     uint64_t inputBytes, size_t atoms, Fn&& fn) {
+    StageResult result;
+    result.caseName = benchCase.name;
+    result.stage = stage;
+    result.atoms = atoms;
+    result.frames = benchCase.frames;
+    result.inputBytes = inputBytes;
+
+    bool resetOk = resetPeakRss();
+    long rssBefore = readProcStatusKB("VmRSS");
+    {
+        MemoryBudget warmupBudget(0);
+        MemoryBudgetScope warmupScope(warmupBudget, nullptr);
+        g_sink = g_sink + fn();
+        result.peakHeapKB = static_cast<long>(warmupBudget.peak() / 1024);
+    }
+    result.peakRssKB = peakRssKB();
+    result.peakRssDeltaKB = resetOk ? std::max(0L, result.peakRssKB - rssBefore) : 0;
+
+    std::vector<double> samples;
+    MemoryBudget budget(0);
+    double total = 0;
+    {
+        MemoryBudgetScope scope(budget, nullptr);
+        while ((total < options.minSeconds || samples.size() < 3) && samples.size() < 100000) {
+            auto start = std::chrono::steady_clock::now();
+            g_sink = g_sink + fn();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            samples.push_back(seconds);
+            total += seconds;
+        }
+    }
+
+    result.iterations = samples.size();
+    result.allocations = static_cast<double>(budget.allocations()) / static_cast<double>(samples.size());
+    result.allocatedBytes = static_cast<double>(budget.allocatedBytes()) / static_cast<double>(samples.size());
+    std::sort(samples.begin(), samples.end());
+    result.bestSeconds = samples.front();
+    result.medianSeconds = samples[samples.size() / 2];
+    return result;
+}
+
+double megabytesPerSecond(const StageResult& result) {
+    return result.medianSeconds > 0 ? static_cast<double>(result.inputBytes) / (1024.0 * 1024.0) / result.medianSeconds : 0;
+}
+
+double atomsPerSecond(const StageResult& result) {
+    return result.medianSeconds > 0 ? static_cast<double>(result.atoms) / result.medianSeconds : 0;
+}
+
+void printResult(const StageResult& result) {
+    std::printf("%-24s %-30s %6zu %10.3f %9.1f %11.3e %11.1f %10ld %10ld\n", result.caseName.c_str(),
+                result.stage.c_str(), result.iterations, result.medianSeconds * 1000.0, megabytesPerSecond(result),
+                atomsPerSecond(result), result.allocations, result.peakHeapKB, result.peakRssDeltaKB);
+    std::fflush(stdout);
+}
+
+// XYZ输入：格式检测与嗅探、行扫描、剪贴板复制与借用、解析、转换为Gaussian log、再写回XYZ
+void benchXYZ(const BenchOptions& options, const BenchCase& benchCase, std::vector<StageResult>& results) {
+    std::string content = generateXYZ(benchCase, options.seed);
+    size_t atomFrames = benchCase.atoms * benchCase.frames;
+
+    results.push_back(runStage(options, benchCase, "is_xyz_format", content.size(), atomFrames, [&]() {
+        return static_cast<size_t>(isXYZFormat(content));
+    }));
+    printResult(results.back());
+
+    results.push_back(runStage(options, benchCase, "sniff_format", content.size(), atomFrames, [&]() {
+        return static_cast<size_t>(sniffFormat(content).format);
+    }));
+    printResult(results.back());
+
+    results.push_back(runStage(options, benchCase, "line_scan", content.size(), atomFrames, [&]() {
+        LineCursor cursor(content);
+        std::string_view line;
+        size_t lines = 0;
+        while (cursor.next(line)) ++lines;
+        return lines;
+    }));
+    printResult(results.back());
+
+    // 剪贴板占用时间：复制模式只占用复制所需的时间，借用模式一直占用到解析结束
+    MemoryClipboardSource clipboard(content);
+    std::string clipboardBuffer;
+    results.push_back(runStage(options, benchCase, "clipboard_copy", content.size(), atomFrames, [&]() {
+        ClipboardText text(clipboard, clipboardBuffer);
+        text.acquire(false);
+        return text.view().size();
+    }));
+    printResult(results.back());
+
+    results.push_back(runStage(options, benchCase, "clipboard_borrow_parse", content.size(), atomFrames, [&]() {
+        ClipboardText text(clipboard, clipboardBuffer);
+        Trajectory borrowed;
+        return static_cast<size_t>(text.acquire(true) && parseXYZContent(text.view(), &borrowed));
+    }));
+    printResult(results.back());
+
+    results.push_back(runStage(options, benchCase, "read_multi_xyz", content.size(), atomFrames, [&]() {
+        return readMultiXYZ(content).totalAtoms();
+    }));
+    printResult(results.back());
+
+    Trajectory trajectory;
+    results.push_back(runStage(options, benchCase, "parse_xyz_content", content.size(), atomFrames, [&]() {
+        trajectory = Trajectory();
+        return static_cast<size_t>(parseXYZContent(content, &trajectory));
+    }));
+    printResult(results.back());
+    if (trajectory.totalAtoms() != atomFrames) {
+        std::printf("%-24s parsed %zu of %zu atoms; skipping the remaining stages\n", benchCase.name.c_str(),
+                    trajectory.totalAtoms(), atomFrames);
+        return;
+    }
+    results.back().bytesPerAtomFrame = static_cast<double>(trajectory.memoryBytes()) / trajectory.totalAtoms();
+
+    std::string gaussianLog = convertToGaussianLog(trajectory);
+    results.push_back(runStage(options, benchCase, "convert_to_gaussian_log", gaussianLog.size(), atomFrames, [&]() {
+        return convertToGaussianLog(trajectory).size();
+    }));
+    printResult(results.back());
+
+    // createXYZString只写出一帧
+    std::string xyz = createXYZString(trajectory, 0);
+    BenchCase singleFrame = benchCase;
+    singleFrame.frames = 1;
+    results.push_back(runStage(options, singleFrame, "create_xyz_string", xyz.size(), trajectory.frameAtomCount(0), [&]() {
+        return createXYZString(trajectory, 0).size();
+    }));
+    printResult(results.back());
+}
+
+// Gaussian clipboard输入：INFO级别（生产默认）与DEBUG级别（逐原子日志消息被构建，但不输出）各测一次
+void benchFrg(const BenchOptions& options, const BenchCase& benchCase, std::vector<StageResult>& results) {
+    std::string content = generateFrg(benchCase, options.seed);
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("xyzbench_" + std::to_string(static_cast<long>(getpid())) + ".frg")).string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    results.push_back(runStage(options, benchCase, "parse_gaussian_clipboard", content.size(), benchCase.atoms, [&]() {
+        return parseGaussianClipboard(path).totalAtoms();
+    }));
+    printResult(results.back());
+
+    g_logger.setLogLevel(LogLevel::DEBUG);
+    results.push_back(runStage(options, benchCase, "parse_gaussian_clipboard_debug", content.size(), benchCase.atoms,
+                               [&]() { return parseGaussianClipboard(path).totalAtoms(); }));
+    g_logger.setLogLevel(LogLevel::INFO);
+    printResult(results.back());
+
+    Trajectory atoms = parseGaussianClipboard(path);
+    if (atoms.totalAtoms() == 0) {
+        std::printf("%-24s no atoms parsed; skipping create_xyz_string\n", benchCase.name.c_str());
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return;
+    }
+    std::string xyz = createXYZString(atoms, 0);
+    results.push_back(runStage(options, benchCase, "create_xyz_string", xyz.size(), atoms.totalAtoms(), [&]() {
+        return createXYZString(atoms, 0).size();
+    }));
+    printResult(results.back());
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+// 基线：查表之前的实现（复制、修整并规范大小写后查std::map），与get_atomic_number对比
+int mapAtomicNumber(const std::string& symbol) {
+    static const std::map<std::string, int> atomicNumbers = []() {
+        std::map<std::string, int> table;
+        for (int number = 1; number <= MAX_ATOMIC_NUMBER; ++number) {
+            table[elementSymbol(number)] = number;
+        }
+        return table;
+    }();
+
+    std::string processed = trim(symbol);
+    if (!processed.empty()) {
+        processed[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(processed[0])));
+        for (size_t i = 1; i < processed.length(); ++i) {
+            processed[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(processed[i])));
+        }
+    }
+
+    auto it = atomicNumbers.find(processed);
+    return (it != atomicNumbers.end()) ? it->second : 0;
+}
+
+// 元素符号查找（大小写混合的常见元素）：查表实现与std::map基线
+void benchElementLookup(const BenchOptions& options, std::vector<StageResult>& results) {
+    BenchCase benchCase;
+    benchCase.name = "element-lookup";
+    benchCase.atoms = options.quick ? 100000 : 1000000;
+
+    SyntheticRandom random(options.seed);
+    std::vector<std::string> symbols;
+    symbols.reserve(benchCase.atoms);
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < benchCase.atoms; ++i) {
+        std::string symbol = pickElement(random);
+        if (random.next() % 8 == 0) {
+            std::transform(symbol.begin(), symbol.end(), symbol.begin(), ::toupper);
+        }
+        bytes += symbol.size();
+        symbols.push_back(std::move(symbol));
+    }
+
+    results.push_back(runStage(options, benchCase, "get_atomic_number", bytes, benchCase.atoms, [&]() {
+        size_t sum = 0;
+        for (const std::string& symbol : symbols) sum += static_cast<size_t>(getAtomicNumber(symbol));
+        return sum;
+    }));
+    printResult(results.back());
+
+    results.push_back(runStage(options, benchCase, "get_atomic_number_map", bytes, benchCase.atoms, [&]() {
+        size_t sum = 0;
+        for (const std::string& symbol : symbols) sum += static_cast<size_t>(mapAtomicNumber(symbol));
+        return sum;
+    }));
+    printResult(results.back());
+}
+
+// 默认用例：覆盖10到1M原子、1到100k帧、LF/CRLF、标准/简化XYZ；--quick缩小规模用于冒烟测试。
+// 标准格式的原子数校验上限为10000，因此1M原子的单帧用例使用简化XYZ与.frg
+std::vector<BenchCase> defaultSuite(bool quick) {
+    size_t large = quick ? 10000 : 1000000;
+    size_t manyFrames = quick ? 1000 : 100000;
+    size_t mdFrames = quick ? 100 : 1000;
+
+    std::vector<BenchCase> suite;
+    auto add = [&](const std::string& name, size_t atoms, size_t frames, bool crlf, bool simplified, bool frg) {
+        BenchCase benchCase;
+        benchCase.name = name;
+        benchCase.atoms = atoms;
+        benchCase.frames = frames;
+        benchCase.crlf = crlf;
+        benchCase.simplified = simplified;
+        benchCase.frg = frg;
+        suite.push_back(benchCase);
+    };
+    add("xyz-10", 10, 1, false, false, false);
+    add("xyz-10x" + std::to_string(manyFrames), 10, manyFrames, false, false, false);
+    add("xyz-1000x" + std::to_string(mdFrames), 1000, mdFrames, false, false, false);
+    add("xyz-1000x" + std::to_string(mdFrames) + "-crlf", 1000, mdFrames, true, false, false);
+    add("xyz-10000x" + std::to_string(mdFrames / 10), 10000, mdFrames / 10, false, false, false);
+    add("simplified-100", 100, 1, false, true, false);
+    add("simplified-" + std::to_string(large), large, 1, false, true, false);
+    add("simplified-" + std::to_string(large) + "-crlf", large, 1, true, true, false);
+    add("frg-10", 10, 1, false, false, true);
+    add("frg-" + std::to_string(large), large, 1, false, false, true);
+    return suite;
+}
+
+// ===== JSON输出与比较 =====
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// 每个结果占一行，便于diff以及--compare逐行读取
+bool writeJson(const std::string& path, const BenchOptions& options, const std::vector<StageResult>& results) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        LOG_ERROR("Cannot write " + path);
+        return false;
+    }
+    out << "{\n";
+    out << "  \"tool\": \"xyzbench\",\n";
+    out << "  \"format\": 1,\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"quick\": " << (options.quick ? "true" : "false") << ",\n";
+    out << "  \"worker_threads\": " << resolveWorkerThreads(g_config.workerThreads) << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const StageResult& r = results[i];
+        char numbers[512];
+        std::snprintf(numbers, sizeof(numbers),
+                      "\"atoms\": %zu, \"frames\": %zu, \"input_bytes\": %llu, \"iterations\": %zu, "
+                      "\"median_ms\": %.6f, \"best_ms\": %.6f, \"mb_per_s\": %.3f, \"atoms_per_s\": %.1f, "
+                      "\"allocations\": %.1f, \"allocated_bytes\": %.0f, \"peak_heap_kb\": %ld, "
+                      "\"peak_rss_kb\": %ld, \"peak_rss_delta_kb\": %ld",
+                      r.atoms, r.frames, static_cast<unsigned long long>(r.inputBytes), r.iterations,
+                      r.medianSeconds * 1000.0, r.bestSeconds * 1000.0, megabytesPerSecond(r), atomsPerSecond(r),
+                      r.allocations, r.allocatedBytes, r.peakHeapKB, r.peakRssKB, r.peakRssDeltaKB);
+        out << "    {\"case\": \"" << jsonEscape(r.caseName) << "\", \"stage\": \"" << jsonEscape(r.stage) << "\", "
+            << numbers;
+        if (r.bytesPerAtomFrame > 0) {
+            out << ", \"bytes_per_atom_frame\": " << std::fixed << std::setprecision(2) << r.bytesPerAtomFrame;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+// 读取本工具写出的JSON（每行一个结果），不是通用JSON解析器
+bool extractField(const std::string& line, const char* name, std::string& value) {
+    std::string key = std::string("\"") + name + "\": ";
+    size_t pos = line.find(key);
+    if (pos == std::string::npos) return false;
+    pos += key.size();
+    if (pos < line.size() && line[pos] == '"') {
+        size_t end = line.find('"', pos + 1);
+        if (end == std::string::npos) return false;
+        value = line.substr(pos + 1, end - pos - 1);
+    } else {
+        size_t end = line.find_first_of(",}", pos);
+        value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    }
+    return true;
+}
+
+struct JsonRow {
+    double medianMs = 0;
+    double allocations = 0;
+    double peakRssDeltaKB = 0;
+};
+
+std::map<std::string, JsonRow> readJsonResults(const std::string& path) {
+    std::map<std::string, JsonRow> rows;
+    std::ifstream in(path);
+    if (!in) {
+        LOG_ERROR("Cannot read " + path);
+        return rows;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string caseName, stage, median, allocations, rss;
+        if (!extractField(line, "case", caseName) || !extractField(line, "stage", stage) ||
+            !extractField(line, "median_ms", median)) {
+            continue;
+        }
+        JsonRow row;
+        row.medianMs = std::atof(median.c_str());
+        if (extractField(line, "allocations", allocations)) row.allocations = std::atof(allocations.c_str());
+        if (extractField(line, "peak_rss_delta_kb", rss)) row.peakRssDeltaKB = std::atof(rss.c_str());
+        rows[caseName + " " + stage] = row;
+    }
+    return rows;
+}
+
+int compareResults(const std::string& basePath, const std::string& newPath) {
+    std::map<std::string, JsonRow> base = readJsonResults(basePath);
+    std::map<std::string, JsonRow> current = readJsonResults(newPath);
+    if (base.empty() || current.empty()) {
+        return 2;
+    }
+
+    std::printf("%-54s %11s %11s %8s %12s %12s\n", "case / stage", "base ms", "new ms", "change", "base allocs",
+                "new allocs");
+    for (const auto& [key, row] : current) {
+        auto found = base.find(key);
+        if (found == base.end()) {
+            std::printf("%-54s %11s %11.3f %8s %12s %12.1f\n", key.c_str(), "-", row.medianMs, "new", "-",
+                        row.allocations);
+            continue;
+        }
+        double change = found->second.medianMs > 0 ? (row.medianMs / found->second.medianMs - 1.0) * 100.0 : 0;
+        std::printf("%-54s %11.3f %11.3f %+7.1f%% %12.1f %12.1f\n", key.c_str(), found->second.medianMs, row.medianMs,
+                    change, found->second.allocations, row.allocations);
+    }
+    for (const auto& [key, row] : base) {
+        if (current.find(key) == current.end()) {
+            std::printf("%-54s %11.3f %11s %8s\n", key.c_str(), row.medianMs, "-", "removed");
+        }
+    }
+    return 0;
+}
+
+// ===== 命令行 =====
+
+void printUsage() {
+    std::cout <<
+        "Usage: xyzbench [options]\n"
+        "       xyzbench --compare BASE.json NEW.json\n"
+        "\n"
+        "Benchmarks the conversion stages on deterministic synthetic inputs and reports median time,\n"
+        "MB/s, atoms/s, allocations per iteration, peak heap and peak RSS growth per stage.\n"
+        "\n"
+        "Options:\n"
+        "  --json FILE        Write results as JSON to FILE\n"
+        "  --quick            Smaller inputs (smoke test)\n"
+        "  --min-time SEC     Minimum measured time per stage (default: 0.5)\n"
+        "  --seed N           Generator seed (default: 1)\n"
+        "  --threads N        worker_threads for parsing/formatting (default: 0 = auto)\n"
+        "  --filter TEXT      Only run cases whose name contains TEXT\n"
+        "  --atoms N          Run a single custom case with N atoms per frame instead of the suite\n"
+        "  --frames N         Frames in the custom case (default: 1)\n"
+        "  --crlf             Custom case uses CRLF line endings\n"
+        "  --simplified       Custom case uses simplified XYZ (element x y z lines only, one frame)\n"
+        "  --frg              Custom case is a Gaussian clipboard (.frg) file\n"
+        "  --compare A B      Compare two JSON result files\n"
+        "  -h, --help         Show this help message\n";
+}
+
+bool parseSize(const char* text, size_t& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || parsed == 0) return false;
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        size_t number;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--compare" && i + 2 < argc) {
+            g_logger.setLogToFile(false);
+            return compareResults(argv[i + 1], argv[i + 2]);
+        } else if (arg == "--json" && hasValue) {
+            options.jsonFile = argv[++i];
+        } else if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--min-time" && hasValue) {
+            options.minSeconds = std::atof(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--atoms" && hasValue && parseSize(argv[i + 1], number)) {
+            options.customCase = true;
+            options.custom.atoms = number;
+            ++i;
+        } else if (arg == "--frames" && hasValue && parseSize(argv[i + 1], number)) {
+            options.custom.frames = number;
+            ++i;
+        } else if (arg == "--crlf") {
+            options.custom.crlf = true;
+        } else if (arg == "--simplified") {
+            options.custom.simplified = true;
+        } else if (arg == "--frg") {
+            options.custom.frg = true;
+        } else {
+            std::cerr << "xyzbench: invalid argument: " << arg << " (see --help)" << std::endl;
+            return 2;
+        }
+    }
+
+    // 日志只保留级别过滤的开销：不输出到任何目标
+    g_logger.setLogToFile(false);
+    g_logger.setLogToConsole(false);
+    g_logger.setLogLevel(LogLevel::INFO);
+    g_config.workerThreads = options.threads;
+
+    std::vector<BenchCase> suite;
+    if (options.customCase) {
+        BenchCase custom = options.custom;
+        if (custom.simplified || custom.frg) custom.frames = 1;
+        custom.name = std::string(custom.frg ? "frg-" : custom.simplified ? "simplified-" : "xyz-") +
+                      std::to_string(custom.atoms) + (custom.frames > 1 ? "x" + std::to_string(custom.frames) : "") +
+                      (custom.crlf ? "-crlf" : "");
+        suite.push_back(custom);
+    } else {
+        suite = defaultSuite(options.quick);
+    }
+
+    std::printf("%-24s %-30s %6s %10s %9s %11s %11s %10s %10s\n", "case", "stage", "iters", "median ms", "MB/s",
+                "atoms/s", "allocs/iter", "heap KB", "peak RSS+KB");
+    std::vector<StageResult> results;
+    for (const BenchCase& benchCase : suite) {
+        if (!options.filter.empty() && benchCase.name.find(options.filter) == std::string::npos) continue;
+        if (benchCase.frg) {
+            benchFrg(options, benchCase, results);
+        } else {
+            benchXYZ(options, benchCase, results);
+        }
+    }
+    if (!options.customCase && (options.filter.empty() || std::string("element-lookup").find(options.filter) != std::string::npos)) {
+        benchElementLookup(options, results);
+    }
+
+    // parse_xyz_content的内存占用（每原子-帧字节数）
+    for (const StageResult& result : results) {
+        if (result.bytesPerAtomFrame > 0) {
+            std::printf("%-24s trajectory memory: %.1f bytes per atom-frame\n", result.caseName.c_str(),
+                        result.bytesPerAtomFrame);
+        }
+    }
+
+    if (!options.jsonFile.empty()) {
+        if (!writeJson(options.jsonFile, options, results)) return 1;
+        std::printf("Results written to %s\n", options.jsonFile.c_str());
+    }
+    return 0;
+}
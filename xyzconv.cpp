@@ -0,0 +1,378 @@
+// xyzconv - 批量转换命令行工具：把目录或文件列表中的.xyz（及.xyzb二进制轨迹）转换为Gaussian .log，
+// 或反向把Gaussian clipboard（.frg）转换为.xyz。多个文件在工作线程间并行转换
+#include "xyz_core.h"
+
+#include <set>
+
+// 命令行选项
+struct CliOptions {
+    std::vector<std::string> inputs;
+    std::string outputDir;        // 空表示写在输入文件旁边
+    unsigned jobs = 0;            // 0表示按CPU核心数
+    bool reverse = false;
+    bool recursive = false;
+    bool quiet = false;
+    int verbosity = 0;
+    bool selectionGiven = false;
+    FrameSelection selection;
+    std::string configFile;
+};
+
+// 单个转换任务
+struct ConversionTask {
+    std::string input;
+    std::string output;
+};
+
+// 单个任务的结果
+struct TaskResult {
+    bool ok = false;
+    uintmax_t inputBytes = 0;
+    uintmax_t outputBytes = 0;
+    size_t frames = 0;
+    size_t atoms = 0;
+};
+
+void printUsage() {
+    std::cout <<
+        "Usage: xyzconv [options] <file|directory>...\n"
+        "\n"
+        "Converts .xyz files (and .xyzb binary trajectories) to Gaussian .log files for GView,\n"
+        "or with --reverse converts Gaussian clipboard .frg files to .xyz.\n"
+        "Directories are scanned for files with the matching extension.\n"
+        "\n"
+        "Options:\n"
+        "  -o, --output DIR    Write results to DIR (default: next to each input file)\n"
+        "  -j, --jobs N        Number of files converted in parallel (default: number of CPUs)\n"
+        "  -r, --reverse       Convert .frg files to .xyz\n"
+        "  -R, --recursive     Scan directories recursively\n"
+        "  -f, --frames SPEC   Frame selection, e.g. stride=10,last=500 or range=0:1000 (default: all)\n"
+        "  -c, --config FILE   Read max_memory_mb, worker_threads, write_buffer_kb, stream_conversion,\n"
+        "                      frame selection and log_level from a config.ini\n"
+        "  -v, --verbose       Log conversion details (repeat for DEBUG)\n"
+        "  -q, --quiet         Only report errors\n"
+        "  -h, --help          Show this help message\n"
+        "\n"
+        "max_memory_mb is shared between the parallel jobs.\n";
+}
+
+// 解析命令行；出错时返回false
+bool parseArguments(int argc, char** argv, CliOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](std::string& out) {
+            if (i + 1 >= argc) {
+                std::cerr << "xyzconv: " << arg << " requires a value" << std::endl;
+                return false;
+            }
+            out = argv[++i];
+            return true;
+        };
+
+        std::string text;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        } else if (arg == "-o" || arg == "--output") {
+            if (!value(options.outputDir)) return false;
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (!value(text)) return false;
+            int jobs;
+            if (!parseInt(text, jobs) || jobs < 1) {
+                std::cerr << "xyzconv: invalid job count: " << text << std::endl;
+                return false;
+            }
+            options.jobs = static_cast<unsigned>(jobs);
+        } else if (arg == "-r" || arg == "--reverse") {
+            options.reverse = true;
+        } else if (arg == "-R" || arg == "--recursive") {
+            options.recursive = true;
+        } else if (arg == "-f" || arg == "--frames") {
+            if (!value(text)) return false;
+            if (!parseFrameSelection(text, options.selection)) {
+                std::cerr << "xyzconv: invalid frame selection: " << text << std::endl;
+                return false;
+            }
+            options.selectionGiven = true;
+        } else if (arg == "-c" || arg == "--config") {
+            if (!value(options.configFile)) return false;
+        } else if (arg == "-v" || arg == "--verbose") {
+            ++options.verbosity;
+        } else if (arg == "-q" || arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "xyzconv: unknown option: " << arg << std::endl;
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    if (options.inputs.empty()) {
+        std::cerr << "xyzconv: no input files or directories given (see --help)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 扩展名比较（不区分大小写）
+bool hasExtension(const std::filesystem::path& path, const std::vector<std::string>& extensions) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+// 展开输入为转换任务：目录按扩展名收集（结果排序），文件直接加入；输出路径重复时跳过后者
+std::vector<ConversionTask> collectTasks(const CliOptions& options) {
+    const std::vector<std::string> extensions = options.reverse ? std::vector<std::string>{".frg"}
+                                                                : std::vector<std::string>{".xyz", ".xyzb"};
+    const char* outputExtension = options.reverse ? ".xyz" : ".log";
+
+    std::vector<std::filesystem::path> files;
+    for (const std::string& input : options.inputs) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(input, ec)) {
+            std::vector<std::filesystem::path> found;
+            auto collect = [&](const std::filesystem::directory_entry& entry) {
+                std::error_code entryEc;
+                if (entry.is_regular_file(entryEc) && hasExtension(entry.path(), extensions)) {
+                    found.push_back(entry.path());
+                }
+            };
+            if (options.recursive) {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(input, ec)) collect(entry);
+            } else {
+                for (const auto& entry : std::filesystem::directory_iterator(input, ec)) collect(entry);
+            }
+            if (ec) {
+                LOG_ERROR("Failed to scan directory " + input + ": " + ec.message());
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else if (std::filesystem::is_regular_file(input, ec)) {
+            files.emplace_back(input);
+        } else {
+            LOG_ERROR("Input not found: " + input);
+        }
+    }
+
+    std::vector<ConversionTask> tasks;
+    std::set<std::string> outputs;
+    for (const std::filesystem::path& file : files) {
+        std::filesystem::path output = file;
+        output.replace_extension(outputExtension);
+        if (!options.outputDir.empty()) {
+            output = std::filesystem::path(options.outputDir) / output.filename();
+        }
+        if (!outputs.insert(output.string()).second) {
+            LOG_WARNING("Skipping " + file.string() + ": another input already writes " + output.string());
+            continue;
+        }
+        tasks.push_back({file.string(), output.string()});
+    }
+    return tasks;
+}
+
+// 把结果写入output：先写入同目录下的.part文件，成功后替换目标文件
+class OutputFile {
+private:
+    std::string target;
+    std::string partial;
+    bool committed = false;
+
+public:
+    OutputFileWriter writer;
+
+    explicit OutputFile(const std::string& path) : target(path), partial(path + ".part"), writer(writeBufferBytes()) {}
+
+    ~OutputFile() {
+        if (!committed) {
+            writer.abandon();
+            std::error_code ec;
+            std::filesystem::remove(partial, ec);
+        }
+    }
+
+    bool create() {
+        std::error_code ec;
+        std::filesystem::remove(partial, ec);
+        bool alreadyExists;
+        if (!writer.create(partial, alreadyExists)) {
+            LOG_ERROR("Failed to create " + partial);
+            return false;
+        }
+        return true;
+    }
+
+    // 文件已关闭后替换目标文件
+    bool commit() {
+        if (!writer.close()) return false;
+        std::error_code ec;
+        std::filesystem::rename(partial, target, ec);
+        if (ec) {
+            LOG_ERROR("Failed to move " + partial + " to " + target + ": " + ec.message());
+            return false;
+        }
+        committed = true;
+        return true;
+    }
+};
+
+// XYZ（或.xyzb）-> Gaussian log
+bool convertToLog(const ConversionTask& task, const FrameSelection& selection, TaskResult& result) {
+    std::error_code ec;
+    result.inputBytes = std::filesystem::file_size(task.input, ec);
+
+    OutputFile output(task.output);
+    if (!output.create()) {
+        return false;
+    }
+
+    StreamStats stats;
+    if (!convertTrajectoryFileToGaussianLog(task.input, output.writer, selection, stats)) {
+        return false;
+    }
+
+    result.frames = stats.frames;
+    result.atoms = stats.atoms;
+    result.outputBytes = output.writer.bytesWritten();
+    return output.commit();
+}
+
+// Gaussian clipboard（.frg）-> XYZ，每帧依次写出
+bool convertToXYZ(const ConversionTask& task, TaskResult& result) {
+    std::error_code ec;
+    result.inputBytes = std::filesystem::file_size(task.input, ec);
+
+    TraceSpan parseSpan("clipboard_file_parse");
+    Trajectory trajectory = parseGaussianClipboard(task.input);
+    parseSpan.end();
+    if (trajectory.totalAtoms() == 0) {
+        LOG_ERROR("No atoms found in " + task.input);
+        return false;
+    }
+
+    OutputFile output(task.output);
+    if (!output.create()) {
+        return false;
+    }
+    std::string xyz;  // 每帧按精确大小直接格式化，帧之间复用
+    for (size_t frame = 0; frame < trajectory.frameCount(); ++frame) {
+        TraceSpan createSpan("create_xyz");
+        xyz.resize(xyzFrameSize(trajectory, frame));
+        formatXYZFrame(&xyz[0], trajectory, frame);
+        createSpan.end();
+        TraceSpan writeSpan("output_write");
+        if (!output.writer.write(xyz)) {
+            return false;
+        }
+    }
+
+    result.frames = trajectory.frameCount();
+    result.atoms = trajectory.totalAtoms();
+    result.outputBytes = output.writer.bytesWritten();
+    return output.commit();
+}
+
+int main(int argc, char** argv) {
+    CliOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        return 2;
+    }
+
+    g_logger.setLogToFile(false);
+    g_logger.setLogLevel(LogLevel::WARNING);
+    if (!options.configFile.empty()) {
+        if (!std::filesystem::exists(options.configFile)) {
+            std::cerr << "xyzconv: config file not found: " << options.configFile << std::endl;
+            return 2;
+        }
+        loadConfig(options.configFile);
+        g_logger.setLogLevel(stringToLogLevel(g_config.logLevel));
+    }
+    if (options.quiet) {
+        g_logger.setLogLevel(LogLevel::ERROR);
+    } else if (options.verbosity > 0) {
+        g_logger.setLogLevel(options.verbosity > 1 ? LogLevel::DEBUG : LogLevel::INFO);
+    }
+
+    // 未指定帧选择时使用配置文件中的frame_range/frame_last/frame_stride（没有配置文件时为全部帧）
+    FrameSelection selection = options.selectionGiven ? options.selection : g_config.frameSelection;
+
+    std::vector<ConversionTask> tasks = collectTasks(options);
+    if (tasks.empty()) {
+        std::cerr << "xyzconv: nothing to convert" << std::endl;
+        return 1;
+    }
+    if (!options.outputDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(options.outputDir, ec);
+    }
+
+    // 文件级并行：内存预算在并行任务间平分，未配置解析线程数时把剩余的核心分给每个任务
+    unsigned jobs = std::min<size_t>(options.jobs > 0 ? options.jobs : resolveWorkerThreads(0), tasks.size());
+    g_config.maxMemoryMB = std::max(50, g_config.maxMemoryMB / static_cast<int>(jobs));
+    if (g_config.workerThreads == 0) {
+        g_config.workerThreads = static_cast<int>(std::max(1u, resolveWorkerThreads(0) / jobs));
+    }
+    LOG_INFO("Converting " + std::to_string(tasks.size()) + " file(s) with " + std::to_string(jobs) + " job(s), " +
+             std::to_string(g_config.workerThreads) + " parser thread(s) and " + std::to_string(g_config.maxMemoryMB) +
+             "MB per job");
+
+    std::vector<TaskResult> results(tasks.size());
+    std::mutex outputMutex;
+    auto startTime = std::chrono::steady_clock::now();
+
+    parallelFor(tasks.size(), jobs, 1, [&](size_t i) {
+        const ConversionTask& task = tasks[i];
+        TaskResult& result = results[i];
+        auto taskStart = std::chrono::steady_clock::now();
+        try {
+            // 每个文件一次计时：-v时输出各阶段耗时，配置启用trace_conversions时写出trace文件。
+            // 每个文件一个内存预算，超出时该文件失败，其余文件继续
+            std::string name = "xyzconv_" + std::filesystem::path(task.input).stem().string();
+            ConversionTrace trace(name);
+            TraceScope traceScope(trace);
+            MemoryBudget budget(conversionMemoryLimit());
+            MemoryBudgetScope memoryScope(budget, name.c_str());
+            result.ok = options.reverse ? convertToXYZ(task, result) : convertToLog(task, selection, result);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception converting " + task.input + ": " + std::string(e.what()));
+            result.ok = false;
+        }
+
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - taskStart).count();
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (!result.ok) {
+            std::cerr << "FAILED " << task.input << (options.verbosity == 0 ? " (run with -v for details)" : "")
+                      << std::endl;
+        } else if (!options.quiet) {
+            std::cout << task.input << " -> " << task.output << " (" << result.frames << " frame(s), "
+                      << result.atoms << " atoms, " << std::fixed << std::setprecision(0) << milliseconds << "ms)"
+                      << std::endl;
+        }
+    });
+
+    size_t succeeded = 0;
+    uintmax_t inputBytes = 0;
+    uintmax_t outputBytes = 0;
+    for (const TaskResult& result : results) {
+        if (!result.ok) continue;
+        ++succeeded;
+        inputBytes += result.inputBytes;
+        outputBytes += result.outputBytes;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    if (!options.quiet) {
+        double megabytes = static_cast<double>(inputBytes) / (1024.0 * 1024.0);
+        std::cout << "Converted " << succeeded << " of " << tasks.size() << " file(s): " << std::fixed
+                  << std::setprecision(1) << megabytes << "MB in, "
+                  << static_cast<double>(outputBytes) / (1024.0 * 1024.0) << "MB out, " << seconds << "s ("
+                  << (seconds > 0 ? megabytes / seconds : 0.0) << " MB/s)" << std::endl;
+    }
+
+    g_logger.shutdown();
+    return succeeded == tasks.size() ? 0 : 1;
+}